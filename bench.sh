@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Builds the game logic for the host machine and runs the tick benchmark.
+# Hardware registers, timers and USART are replaced by the stubs in host/
+#
+# Usage: ./bench.sh [ticks] [frame mode] [record|replay <file>]
+# Extra compiler flags can be passed with CFLAGS, e.g. CFLAGS=-DFLOAT_PHYSICS ./bench.sh
+
+# Exit on any error
+set -e
+
+# Configuration
+CC="${CC:-cc}"
+SRC_DIR="src"
+HOST_DIR="host"
+BUILD_DIR="build/host"
+TARGET="bench"
+
+mkdir -p $BUILD_DIR
+
+command -v $CC >/dev/null 2>&1 || { echo "❌ $CC not found. Set CC to a host C compiler"; exit 1; }
+
+# Only the hardware-independent sources, the rest is stubbed
+C_FILES="$HOST_DIR/host.c $HOST_DIR/replay.c $HOST_DIR/bench.c $SRC_DIR/game/game.c $SRC_DIR/game/aim.c $SRC_DIR/game/collision.c $SRC_DIR/game/entities.c $SRC_DIR/frame/frame.c"
+
+echo "🔧 Compiling host benchmark..."
+
+$CC -std=gnu11 -Wall -O2 -DHOST -DF_CPU=16000000UL $CFLAGS -I$SRC_DIR -I$HOST_DIR -o $BUILD_DIR/$TARGET $C_FILES -lm
+
+echo "⏱️  Running benchmark..."
+
+./$BUILD_DIR/$TARGET "$@"
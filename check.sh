@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Builds and runs the host-side checks of the game logic, with the stubs in host/:
+# - physics: the Q8.8 physics stay within tolerance of the float reference on the same inputs
+# - queue: DECLARE_QUEUE loses or reorders nothing between a producer and a consumer thread
+#
+# Usage: ./check.sh
+# Extra compiler flags can be passed with CFLAGS, e.g. CFLAGS=-fsanitize=thread ./check.sh
+
+# Exit on any error
+set -e
+
+# Configuration, keep in sync with bench.sh
+CC="${CC:-cc}"
+SRC_DIR="src"
+HOST_DIR="host"
+BUILD_DIR="build/host"
+
+mkdir -p $BUILD_DIR
+
+command -v $CC >/dev/null 2>&1 || { echo "❌ $CC not found. Set CC to a host C compiler"; exit 1; }
+
+CFLAGS="-std=gnu11 -Wall -O2 -DHOST -DF_CPU=16000000UL -I$SRC_DIR -I$HOST_DIR $CFLAGS"
+GAME_FILES="$HOST_DIR/host.c $SRC_DIR/game/game.c $SRC_DIR/game/aim.c $SRC_DIR/game/collision.c $SRC_DIR/game/entities.c $SRC_DIR/frame/frame.c"
+
+echo "🔧 Compiling physics check (float and fixed point)..."
+
+$CC $CFLAGS -DFLOAT_PHYSICS -o $BUILD_DIR/physics_check_float $HOST_DIR/physics_check.c $GAME_FILES -lm
+$CC $CFLAGS -o $BUILD_DIR/physics_check $HOST_DIR/physics_check.c $GAME_FILES -lm
+
+echo "⏱️  Checking physics..."
+
+./$BUILD_DIR/physics_check_float write $BUILD_DIR/physics_trace.txt
+./$BUILD_DIR/physics_check compare $BUILD_DIR/physics_trace.txt
+
+echo "🔧 Compiling queue stress test..."
+
+$CC $CFLAGS -o $BUILD_DIR/queue_stress $HOST_DIR/queue_stress.c -pthread
+
+echo "⏱️  Stressing the queue..."
+
+./$BUILD_DIR/queue_stress
+
+echo "✅ All checks passed"
@@ -0,0 +1,311 @@
+import {
+	BACKEND_TO_FRONTEND,
+	BITS_PER_COLOR,
+	FRAME_CHECK_POLY,
+	SCREENX,
+	SCREENY
+} from './generated';
+
+export const COLORS_PER_BYTE = Math.floor((8 - 1) / BITS_PER_COLOR);
+const FRAME_COLS = Math.floor(SCREENX / COLORS_PER_BYTE);
+const FRAME_CELLS = SCREENY * FRAME_COLS;
+const COLOR_MASK = (1 << BITS_PER_COLOR) - 1;
+
+// CRC-8 of each byte, the same table as the backend's frame_crc_table
+const CRC_TABLE = new Uint8Array(256);
+for (let i = 0; i < 256; i++) {
+	let crc = i;
+	for (let bit = 0; bit < 8; bit++) {
+		crc = (crc & 0x80 ? (crc << 1) ^ FRAME_CHECK_POLY : crc << 1) & 0xff;
+	}
+	CRC_TABLE[i] = crc;
+}
+
+// Sent by the backend after each frame
+export interface FrameStats {
+	// Of the frame, wraps at 128
+	sequence: number;
+	// When the frame was handed to the USART, wraps at 2^14 ms
+	time_ms: number;
+	// Last game tick, building the frame, and waiting for the previous one to be sent before that
+	tick_us: number;
+	frame_us: number;
+	wait_us: number;
+}
+
+export interface DecoderEvents {
+	// `frame` is the decoder's own buffer: copy it if it must outlive the current push()
+	frame(frame: Uint8Array): void;
+	stats(stats: FrameStats): void;
+	score(score: number): void;
+	bullets(bullets: number): void;
+	booted(): void;
+}
+
+const FRAME_STATS_LEN = 9;
+
+// Streaming decoder of the backend messages.
+//
+// Every chunk read from the serial port is consumed in place, and the state machine carries over
+// from one chunk to the next: a message can be split anywhere. Pixels are written straight into
+// a preallocated frame, which is also the base the delta frames are applied on.
+export class FrameDecoder {
+	// One color per pixel, row by row
+	readonly frame = new Uint8Array(SCREENX * SCREENY);
+	// Frames that ended with the wrong amount of data
+	corrupted_frames = 0;
+	// Frames whose FRAME_CHECK did not match their data
+	check_failures = 0;
+
+	private events: DecoderEvents;
+	// Last command byte, the data bytes that follow belong to it
+	private command: BACKEND_TO_FRONTEND | undefined;
+	// `frame` holds a complete frame, delta frames can be applied to it
+	private base_valid = false;
+	// A frame start has been seen since the reset: before that, the stream was joined mid-frame
+	private synced = false;
+	// The frame in progress was dropped before its end, its FRAME_END is expected
+	private frame_dropped = false;
+	// Keyframe cells read so far
+	private cells = 0;
+	// The next keyframe data byte is the length of a run of empty cells
+	private pending_run = false;
+	// (col, row, value) of the delta cell being read
+	private delta_cell = new Uint8Array(3);
+	private delta_len = 0;
+	// CRC-8 of the data bytes of the frame, compared with FRAME_CHECK
+	private check = 0;
+	// FRAME_CHECK data bytes still expected (high bit, then low 7 bits), and the value read so far
+	private pending_check = 0;
+	private received_check = 0;
+	private check_failed = false;
+	// FRAME_STATS data bytes read so far
+	private stats_bytes = new Uint8Array(FRAME_STATS_LEN);
+	private stats_len = 0;
+
+	constructor(events: DecoderEvents) {
+		this.events = events;
+	}
+
+	// Forgets everything, e.g. when the port is reopened or the backend reboots
+	reset() {
+		this.command = undefined;
+		this.base_valid = false;
+		this.synced = false;
+		this.start_frame();
+	}
+
+	push(chunk: Uint8Array) {
+		for (let i = 0; i < chunk.length; i++) {
+			const byte = chunk[i];
+			if (byte & (1 << 7)) {
+				this.on_command(byte & ~(1 << 7));
+			} else if (this.pending_check) {
+				this.received_check = (this.received_check << 7) | byte;
+				if (--this.pending_check == 0) {
+					this.check_failed = this.received_check != this.check;
+				}
+			} else {
+				this.on_data(byte);
+			}
+		}
+	}
+
+	private start_frame() {
+		this.cells = 0;
+		this.pending_run = false;
+		this.delta_len = 0;
+		this.check = 0;
+		this.pending_check = 0;
+		this.check_failed = false;
+		this.frame_dropped = false;
+	}
+
+	// The frame in progress cannot be trusted anymore, wait for the next keyframe
+	private drop_frame(reason: string) {
+		console.error(`${reason}. Resetting.`);
+		if (this.check_failed) {
+			this.check_failures++;
+		} else {
+			this.corrupted_frames++;
+		}
+		this.base_valid = false;
+		this.command = undefined;
+		this.start_frame();
+	}
+
+	// A frame end or check whose start was lost. If it was a delta frame, its changes are missing
+	// from the base, which cannot be trusted anymore
+	private drop_orphan(reason: string) {
+		if (this.synced) {
+			this.drop_frame(reason);
+		}
+	}
+
+	private on_command(command: number) {
+		switch (command) {
+			case BACKEND_TO_FRONTEND.SCORE:
+			case BACKEND_TO_FRONTEND.BULLETS:
+				this.command = command;
+				break;
+			case BACKEND_TO_FRONTEND.FRAME_STATS:
+				this.command = command;
+				this.stats_len = 0;
+				break;
+			case BACKEND_TO_FRONTEND.BOOTED:
+				console.info('booted msg');
+				this.reset();
+				this.events.booted();
+				break;
+			case BACKEND_TO_FRONTEND.FRAME_START:
+				this.command = command;
+				this.synced = true;
+				// Overwritten in place, no longer a valid base until FRAME_END
+				this.base_valid = false;
+				this.start_frame();
+				break;
+			case BACKEND_TO_FRONTEND.DELTA_FRAME_START:
+				this.command = command;
+				this.synced = true;
+				this.start_frame();
+				break;
+			case BACKEND_TO_FRONTEND.RLE_RUN:
+				if (this.command != BACKEND_TO_FRONTEND.FRAME_START) {
+					console.warn('RLE run outside of a keyframe. Discarding.');
+					break;
+				}
+				this.pending_run = true;
+				break;
+			case BACKEND_TO_FRONTEND.FRAME_CHECK:
+				if (
+					this.command != BACKEND_TO_FRONTEND.FRAME_START &&
+					this.command != BACKEND_TO_FRONTEND.DELTA_FRAME_START
+				) {
+					// The frame start was lost
+					this.drop_orphan('Frame check without a frame start');
+					this.frame_dropped = this.synced;
+					break;
+				}
+				this.pending_check = 2;
+				this.received_check = 0;
+				break;
+			case BACKEND_TO_FRONTEND.FRAME_END:
+				this.end_frame();
+				break;
+			default:
+				console.warn(`Unsupported command: ${command}. Discarding.`);
+				break;
+		}
+	}
+
+	private end_frame() {
+		if (this.check_failed) {
+			this.drop_frame('Frame check mismatch');
+			return;
+		}
+		if (this.pending_check != 0) {
+			this.drop_frame('Frame check cut short');
+			return;
+		}
+
+		if (this.command == BACKEND_TO_FRONTEND.DELTA_FRAME_START) {
+			if (!this.base_valid) {
+				// Nothing to apply the changes to, wait for the next keyframe
+				this.command = undefined;
+				return;
+			}
+			if (this.delta_len != 0) {
+				this.drop_frame('Delta frame ended in the middle of a cell');
+				return;
+			}
+		} else if (this.command == BACKEND_TO_FRONTEND.FRAME_START) {
+			if (this.cells != FRAME_CELLS || this.pending_run) {
+				this.drop_frame(`Frame data mismatch. Expected ${FRAME_CELLS}, got ${this.cells}`);
+				return;
+			}
+		} else if (this.frame_dropped) {
+			// Counted when it was dropped
+			this.frame_dropped = false;
+			return;
+		} else {
+			// The frame start was lost
+			this.drop_orphan('Frame end without a frame start');
+			return;
+		}
+
+		this.command = undefined;
+		this.base_valid = true;
+		this.events.frame(this.frame);
+	}
+
+	private on_data(byte: number) {
+		switch (this.command) {
+			case BACKEND_TO_FRONTEND.SCORE:
+				this.command = undefined;
+				this.events.score(byte);
+				break;
+			case BACKEND_TO_FRONTEND.BULLETS:
+				this.command = undefined;
+				this.events.bullets(byte);
+				break;
+			case BACKEND_TO_FRONTEND.FRAME_STATS:
+				this.stats_bytes[this.stats_len++] = byte;
+				if (this.stats_len == FRAME_STATS_LEN) {
+					this.command = undefined;
+					const bytes = this.stats_bytes;
+					this.events.stats({
+						sequence: bytes[0],
+						time_ms: (bytes[1] << 7) | bytes[2],
+						tick_us: (bytes[3] << 7) | bytes[4],
+						frame_us: (bytes[5] << 7) | bytes[6],
+						wait_us: (bytes[7] << 7) | bytes[8]
+					});
+				}
+				break;
+			case BACKEND_TO_FRONTEND.FRAME_START:
+				this.check = CRC_TABLE[this.check ^ byte];
+				this.on_keyframe_data(byte);
+				break;
+			case BACKEND_TO_FRONTEND.DELTA_FRAME_START:
+				this.check = CRC_TABLE[this.check ^ byte];
+				this.delta_cell[this.delta_len++] = byte;
+				if (this.delta_len == 3) {
+					this.delta_len = 0;
+					if (this.base_valid) {
+						const cell = this.delta_cell;
+						this.write_cell(cell[1] * SCREENX + cell[0] * COLORS_PER_BYTE, cell[2]);
+					}
+				}
+				break;
+		}
+	}
+
+	private on_keyframe_data(byte: number) {
+		// `byte` empty cells, or one cell
+		const len = this.pending_run ? byte : 1;
+		if (this.cells + len > FRAME_CELLS) {
+			this.drop_frame('Received too many frame bytes');
+			this.frame_dropped = true;
+			return;
+		}
+
+		// The screen width is a multiple of COLORS_PER_BYTE: cells are contiguous in `frame`
+		const pixel = this.cells * COLORS_PER_BYTE;
+		if (this.pending_run) {
+			this.pending_run = false;
+			this.frame.fill(0, pixel, pixel + len * COLORS_PER_BYTE);
+		} else {
+			this.write_cell(pixel, byte);
+		}
+		this.cells += len;
+	}
+
+	private write_cell(pixel: number, value: number) {
+		if (pixel + COLORS_PER_BYTE > this.frame.length) {
+			return;
+		}
+		for (let i = 0; i < COLORS_PER_BYTE; i++) {
+			this.frame[pixel + i] = (value >> (i * BITS_PER_COLOR)) & COLOR_MASK;
+		}
+	}
+}
@@ -0,0 +1,129 @@
+/// <reference lib="webworker" />
+
+// Frame decoding, off the UI thread.
+//
+// The page opens the port (requestPort() needs a user gesture) and transfers its readable stream
+// here. Transferring only moves the reading end: the port still fills the stream from the page's
+// event loop, so a busy page delays the chunks (the port buffer absorbs that) but the decoding
+// itself no longer competes with Svelte for the main thread. Completed frames are posted back as
+// transferred buffers.
+
+import { FrameDecoder } from './decoder';
+import { LinkStatsCollector, type LinkStats } from './link_stats';
+
+export type WorkerRequest =
+	| { type: 'start'; readable: ReadableStream<Uint8Array> }
+	// Cancels the read loop, answered with 'closed' once the stream is released
+	| { type: 'stop' };
+
+export type WorkerMessage =
+	// `frame` holds one color per pixel. `sequence` counts the frames decoded since 'start'.
+	// `decode_ms` is the time spent decoding the bytes of this frame
+	| { type: 'frame'; frame: ArrayBuffer; sequence: number; decode_ms: number }
+	| { type: 'score'; score: number }
+	| { type: 'bullets'; bullets: number }
+	// The backend rebooted and is back to plain keyframes until it gets SET_FRAME_MODE again
+	| { type: 'booted' }
+	// Once per second
+	| { type: 'stats'; stats: LinkStats }
+	| { type: 'closed'; error?: string };
+
+const worker = self as unknown as DedicatedWorkerGlobalScope;
+
+function post(message: WorkerMessage, transfer: Transferable[] = []) {
+	worker.postMessage(message, transfer);
+}
+
+let sequence = 0;
+let stats = new LinkStatsCollector();
+// Decoding time of the frame in progress, accumulated over the chunks it spans
+let decode_ms = 0;
+let push_start = 0;
+
+const decoder = new FrameDecoder({
+	frame(frame) {
+		const now = performance.now();
+		stats.on_frame(now, decode_ms + now - push_start);
+		// A copy: the decoder keeps writing into its buffer. Transferred, not cloned again
+		const buffer = frame.slice().buffer;
+		post(
+			{
+				type: 'frame',
+				frame: buffer,
+				sequence: sequence++,
+				decode_ms: decode_ms + now - push_start
+			},
+			[buffer]
+		);
+		decode_ms = 0;
+		push_start = now;
+	},
+	stats: (frame_stats) => stats.on_stats(frame_stats),
+	score: (score) => post({ type: 'score', score }),
+	bullets: (bullets) => post({ type: 'bullets', bullets }),
+	booted: () => post({ type: 'booted' })
+});
+
+let reader: ReadableStreamDefaultReader<Uint8Array> | null = null;
+
+setInterval(() => {
+	post({
+		type: 'stats',
+		stats: stats.take(decoder.corrupted_frames, decoder.check_failures)
+	});
+}, 1000);
+
+async function read_loop(readable: ReadableStream<Uint8Array>) {
+	reader = readable.getReader();
+	sequence = 0;
+	decode_ms = 0;
+	stats = new LinkStatsCollector();
+	decoder.corrupted_frames = 0;
+	decoder.check_failures = 0;
+	decoder.reset();
+
+	let error: string | undefined;
+	try {
+		while (true) {
+			const { value, done } = await reader.read();
+			if (done) {
+				// reader.cancel() has been called.
+				break;
+			}
+			if (value && value.length > 0) {
+				stats.on_bytes(value.length);
+				push_start = performance.now();
+				decoder.push(value);
+				decode_ms += performance.now() - push_start;
+			}
+		}
+	} catch (e: any) {
+		error = e.message;
+		console.error('Read loop error:', e);
+	} finally {
+		reader.releaseLock();
+		reader = null;
+		post({ type: 'closed', error });
+	}
+}
+
+worker.onmessage = async (event: MessageEvent<WorkerRequest>) => {
+	const request = event.data;
+	switch (request.type) {
+		case 'start':
+			read_loop(request.readable);
+			break;
+		case 'stop':
+			if (reader) {
+				try {
+					// Makes the read() in read_loop resolve with { done: true }
+					await reader.cancel();
+				} catch (e: any) {
+					console.warn('Error cancelling the reader:', e.message);
+				}
+			} else {
+				post({ type: 'closed' });
+			}
+			break;
+	}
+};
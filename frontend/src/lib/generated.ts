@@ -5,6 +5,10 @@ export const SCREENX = 60;
 export const SCREENY = 60;
 export const BAUD = 1000000;
 export const BITS_PER_COLOR = 2;
+export const FRAME_MODE_DELTA = 1;
+export const FRAME_MODE_RLE = 2;
+export const FRAME_MODE_CHECK = 4;
+export const FRAME_CHECK_POLY = 7;
 
 export enum BACKEND_TO_FRONTEND {
     FRAME_START = 0,
@@ -12,9 +16,17 @@ export enum BACKEND_TO_FRONTEND {
     BOOTED = 2,
     SCORE = 3,
     BULLETS = 4,
+    DELTA_FRAME_START = 5,
+    RLE_RUN = 6,
+    FRAME_CHECK = 7,
+    FRAME_STATS = 8,
 }
 
 export enum FRONTEND_TO_BACKEND {
     BUTTON_PRESS = 0,
+    SET_FRAME_MODE = 1,
+    SET_AIM = 2,
+    RELEASE_AIM = 3,
+    PAUSE = 4,
 }
 
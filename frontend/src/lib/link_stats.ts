@@ -0,0 +1,127 @@
+import type { FrameStats } from './decoder';
+
+// One second of end-to-end measurements: the MCU side comes from FRAME_STATS, the link from the
+// decoder counters, the browser side from the frame arrival times
+export interface LinkStats {
+	bytes: number;
+	frames: number;
+	// Since the connection: sent by the MCU but never decoded, and why
+	dropped_frames: number;
+	corrupted_frames: number;
+	check_failures: number;
+	// Between two decoded frames, in the browser and on the MCU
+	interval_p50_ms: number;
+	interval_p99_ms: number;
+	mcu_interval_p50_ms: number;
+	mcu_interval_p99_ms: number;
+	tick_us_mean: number;
+	tick_us_max: number;
+	frame_us_mean: number;
+	frame_us_max: number;
+	wait_us_mean: number;
+	wait_us_max: number;
+	decode_ms_mean: number;
+}
+
+const SEQUENCE_MASK = 0x7f;
+const TIME_MASK = 0x3fff;
+
+function percentile(sorted: number[], p: number): number {
+	if (sorted.length == 0) {
+		return 0;
+	}
+	return sorted[Math.min(sorted.length - 1, Math.floor((sorted.length * p) / 100))];
+}
+
+function mean(values: number[]): number {
+	return values.length == 0 ? 0 : values.reduce((sum, value) => sum + value, 0) / values.length;
+}
+
+export class LinkStatsCollector {
+	// Totals since the first FRAME_STATS
+	private sent = 0;
+	private decoded = 0;
+	private last_sequence: number | null = null;
+	private last_time_ms: number | null = null;
+	private last_frame_at: number | null = null;
+
+	// Current window
+	private bytes = 0;
+	private frames = 0;
+	private intervals: number[] = [];
+	private mcu_intervals: number[] = [];
+	private tick_us: number[] = [];
+	private frame_us: number[] = [];
+	private wait_us: number[] = [];
+	private decode_ms: number[] = [];
+
+	on_bytes(len: number) {
+		this.bytes += len;
+	}
+
+	on_frame(now: number, decode_ms: number) {
+		if (this.last_frame_at != null) {
+			this.intervals.push(now - this.last_frame_at);
+		}
+		this.last_frame_at = now;
+		this.frames++;
+		this.decode_ms.push(decode_ms);
+		if (this.last_sequence != null) {
+			this.decoded++;
+		}
+	}
+
+	on_stats(stats: FrameStats) {
+		if (this.last_sequence != null) {
+			// The same frame again if its frame task was skipped
+			const new_frames = (stats.sequence - this.last_sequence) & SEQUENCE_MASK;
+			if (new_frames == 0) {
+				return;
+			}
+			this.sent += new_frames;
+		}
+		if (this.last_time_ms != null) {
+			this.mcu_intervals.push((stats.time_ms - this.last_time_ms) & TIME_MASK);
+		}
+		this.last_sequence = stats.sequence;
+		this.last_time_ms = stats.time_ms;
+		this.tick_us.push(stats.tick_us);
+		this.frame_us.push(stats.frame_us);
+		this.wait_us.push(stats.wait_us);
+	}
+
+	// Closes the current window
+	take(corrupted_frames: number, check_failures: number): LinkStats {
+		const intervals = this.intervals.sort((a, b) => a - b);
+		const mcu_intervals = this.mcu_intervals.sort((a, b) => a - b);
+		const stats: LinkStats = {
+			bytes: this.bytes,
+			frames: this.frames,
+			// A frame is decoded just before its FRAME_STATS arrives
+			dropped_frames: Math.max(0, this.sent - this.decoded),
+			corrupted_frames,
+			check_failures,
+			interval_p50_ms: percentile(intervals, 50),
+			interval_p99_ms: percentile(intervals, 99),
+			mcu_interval_p50_ms: percentile(mcu_intervals, 50),
+			mcu_interval_p99_ms: percentile(mcu_intervals, 99),
+			tick_us_mean: mean(this.tick_us),
+			tick_us_max: Math.max(0, ...this.tick_us),
+			frame_us_mean: mean(this.frame_us),
+			frame_us_max: Math.max(0, ...this.frame_us),
+			wait_us_mean: mean(this.wait_us),
+			wait_us_max: Math.max(0, ...this.wait_us),
+			decode_ms_mean: mean(this.decode_ms)
+		};
+
+		this.bytes = 0;
+		this.frames = 0;
+		this.intervals = [];
+		this.mcu_intervals = [];
+		this.tick_us = [];
+		this.frame_us = [];
+		this.wait_us = [];
+		this.decode_ms = [];
+		return stats;
+	}
+}
@@ -1,15 +1,26 @@
 import { writable } from 'svelte/store';
-import { BACKEND_TO_FRONTEND, BAUD, BITS_PER_COLOR, SCREENX, SCREENY } from './generated';
+import type { WorkerMessage, WorkerRequest } from './decoder.worker';
+import type { LinkStats } from './link_stats';
+import {
+	BAUD,
+	FRAME_MODE_CHECK,
+	FRAME_MODE_DELTA,
+	FRAME_MODE_RLE,
+	FRONTEND_TO_BACKEND,
+	SCREENX,
+	SCREENY
+} from './generated';
 
 // Reactive stores for the Svelte component to subscribe to
 export const is_connected = writable<boolean>(false);
 export const status_message = writable<string>("Click 'Connect' to select the serial port.");
 export const bytes_per_second = writable<number>(0);
-export const ready_frame = writable<number[]>(Array(SCREENX * SCREENY).fill(0));
-let bytes_queue: number[] = [];
+export const ready_frame = writable<Uint8Array>(new Uint8Array(SCREENX * SCREENY));
 
 let frames = 0;
 export const fps = writable(0);
+// Updated every second by the worker, null until connected
+export const link_stats = writable<LinkStats | null>(null);
 
 export const bullets = writable(0);
 export const score = writable(0);
@@ -19,156 +30,76 @@ setInterval(() => {
 	frames = 0;
 }, 1000);
 
-const COLORS_PER_BYTE = Math.floor((8 - 1) / BITS_PER_COLOR);
-const TOTAL_FRAME_TRANSFER_BYTES = SCREENY * Math.floor(SCREENX / COLORS_PER_BYTE);
-let frame: number[] = [];
-let frame_bytes_read = 0;
-let byte_n = 0; // Assuming this is for debugging, retained.
+// The most compact frames the decoder understands, asked for on connection and after a reboot
+const FRAME_MODE = FRAME_MODE_DELTA | FRAME_MODE_RLE | FRAME_MODE_CHECK;
 
 // --- New Configuration ---
 const ARDUINO_BOOT_DELAY_MS = 2000; // Wait 2 seconds for Arduino to boot. Adjust as needed.
 
-function reset() {
-	frame_bytes_read = 0;
-	frame = [];
-	// byte_n = 0; // Reset byte_n if it's per-connection/frame sequence
-}
-
 let port: SerialPort | null = null;
-let reader: ReadableStreamDefaultReader<Uint8Array> | null = null;
 let writer: WritableStreamDefaultWriter<Uint8Array> | null = null;
-let keep_reading = false;
 let _is_connected_internal = false;
 
-let last_command: BACKEND_TO_FRONTEND | undefined;
-
 is_connected.subscribe((value) => (_is_connected_internal = value));
 
-setInterval(process, 10);
-
-function process() {
-	let byte_command = bytes_queue.shift();
-	if (byte_command == undefined) {
-		return;
+// Reads and decodes the serial port, see decoder.worker.ts. Created on the first connection:
+// this module is also evaluated during server side rendering, where there are no workers
+let worker: Worker | null = null;
+// Resolved when the worker has released the port's readable stream
+let worker_closed: Promise<void> = Promise.resolve();
+let resolve_worker_closed = () => {};
+
+function on_worker_message(event: MessageEvent<WorkerMessage>) {
+	const message = event.data;
+	switch (message.type) {
+		case 'frame':
+			frames++;
+			// Owned by this thread now, no copy needed
+			ready_frame.set(new Uint8Array(message.frame));
+			break;
+		case 'score':
+			score.set(message.score);
+			break;
+		case 'bullets':
+			bullets.set(message.bullets);
+			break;
+		case 'booted':
+			send_command(FRONTEND_TO_BACKEND.SET_FRAME_MODE, FRAME_MODE);
+			break;
+		case 'stats':
+			bytes_per_second.set(message.stats.bytes);
+			link_stats.set(message.stats);
+			break;
+		case 'closed':
+			console.log('Exited read loop.');
+			resolve_worker_closed();
+			if (message.error && _is_connected_internal) {
+				status_message.set(`Connection lost due to read error: ${message.error}. Please reconnect.`);
+				disconnect_serial_port_internal().then(() => is_connected.set(false));
+			}
+			break;
 	}
-	byte_n++;
-
-	let is_command = !!(byte_command & (1 << 7));
-	let byte = byte_command & ~(1 << 7);
-
-	if (is_command) {
-		// Command
-		switch (byte) {
-			case BACKEND_TO_FRONTEND.SCORE:
-				last_command = BACKEND_TO_FRONTEND.SCORE;
-				break;
-			case BACKEND_TO_FRONTEND.BULLETS:
-				last_command = BACKEND_TO_FRONTEND.BULLETS;
-				break;
-			case BACKEND_TO_FRONTEND.BOOTED:
-				reset();
-				console.info('booted msg');
-				break;
-			case BACKEND_TO_FRONTEND.FRAME_START:
-				last_command = BACKEND_TO_FRONTEND.FRAME_START;
-				console.info('FRAME_START');
-				reset();
-				break;
-			case BACKEND_TO_FRONTEND.FRAME_END:
-				console.log('FRAME_END');
-				if (frame_bytes_read != TOTAL_FRAME_TRANSFER_BYTES) {
-					// Consider a more graceful error recovery or logging here
-					console.error(
-						`Frame data mismatch. Expected ${TOTAL_FRAME_TRANSFER_BYTES}, got ${frame_bytes_read}. Resetting.`
-					);
-					// Optionally send an error status to the UI
-					// status_message.set("Error: Incomplete frame received.");
-					reset(); // Reset to try and recover
-					// Do not throw an error that stops the read loop, unless it's unrecoverable
-					break; // Break from switch, process() will be called again if queue has data
-				}
-				ready_frame.set(structuredClone(frame));
-				frames++;
-				reset();
-				break;
-			default:
-				console.warn(`Unsupported command: ${byte}. Discarding.`);
-				// To prevent errors from stopping the process, just log and continue
-				// throw new Error('unsupported command');
-				break; // Break from switch
-		}
-	} else {
-		switch (last_command) {
-			case BACKEND_TO_FRONTEND.BULLETS:
-				last_command = undefined;
-				bullets.set(byte);
-				break;
-			case BACKEND_TO_FRONTEND.SCORE:
-				last_command = undefined;
-				score.set(byte);
-				break;
-			case BACKEND_TO_FRONTEND.FRAME_START:
-				// Data
-				frame_bytes_read++;
-				for (let i = 0; i < COLORS_PER_BYTE; i++) {
-					const mask = (1 << BITS_PER_COLOR) - 1;
-					const extractedBits = (byte >> (i * BITS_PER_COLOR)) & mask;
-					frame.push(extractedBits);
-				}
+}
 
-				if (frame_bytes_read >= TOTAL_FRAME_TRANSFER_BYTES) {
-					console.error('Received too many frame bytes');
-				}
-				break;
-		}
+function start_worker(readable: ReadableStream<Uint8Array>) {
+	if (!worker) {
+		worker = new Worker(new URL('./decoder.worker.ts', import.meta.url), { type: 'module' });
+		worker.onmessage = on_worker_message;
 	}
 
-	if (bytes_queue.length > 0) {
-		process();
-	}
+	worker_closed = new Promise((resolve) => (resolve_worker_closed = resolve));
+	const request: WorkerRequest = { type: 'start', readable };
+	// Streams are transferable: the worker gets the reading end, the port still feeds it from here
+	worker.postMessage(request, [readable]);
 }
 
-let current_byte_count = 0;
-setInterval(() => {
-	bytes_per_second.set(current_byte_count);
-	current_byte_count = 0;
-}, 1000);
-
-async function read_loop() {
-	try {
-		while (port?.readable && keep_reading && reader) {
-			const { value, done } = await reader.read();
-			if (done) {
-				// reader.cancel() has been called.
-				break;
-			}
-			if (value && value.length > 0) {
-				current_byte_count += value.length;
-				bytes_queue.push(...value);
-			}
-		}
-	} catch (error: any) {
-		if (keep_reading) {
-			status_message.set(`Read loop error: ${error.message}. Connection may be lost.`);
-			console.error('Read loop error:', error);
-			// Consider triggering a disconnect or attempting a reconnect here
-			await disconnect_serial_port_internal();
-			is_connected.set(false);
-			status_message.set(`Connection lost due to read error: ${error.message}. Please reconnect.`);
-		}
-	} finally {
-		console.log('Exited read loop.');
-		// Ensure reader is released if loop exits unexpectedly while still "connected"
-		if (reader && keep_reading) {
-			try {
-				await reader.cancel(); // This should lead to reader.releaseLock() being safe
-				reader.releaseLock();
-			} catch (e) {
-				/* ignore */
-			}
-			reader = null;
-		}
+async function stop_worker() {
+	if (!worker) {
+		return;
 	}
+	const request: WorkerRequest = { type: 'stop' };
+	worker.postMessage(request);
+	await worker_closed;
 }
 
 export async function connect_to_serial_port() {
@@ -183,8 +114,6 @@ export async function connect_to_serial_port() {
 	if (_is_connected_internal || port) {
 		await disconnect_serial_port();
 	}
-	bytes_queue = []; // Clear any residual data in the queue
-	reset(); // Reset framing logic
 
 	try {
 		status_message.set('Requesting serial port selection...');
@@ -271,10 +200,8 @@ export async function connect_to_serial_port() {
 		}
 		// --- End Stale Data Purge and Boot Wait Logic ---
 
-		// Ensure main reader and writer are set up *after* boot wait
-		if (port.readable) {
-			reader = port.readable.getReader();
-		} else {
+		// Ensure the reader and writer are set up *after* boot wait
+		if (!port.readable) {
 			throw new Error('Serial port is not readable after boot wait.');
 		}
 		if (port.writable) {
@@ -284,20 +211,15 @@ export async function connect_to_serial_port() {
 			// Not throwing an error, as some applications might be read-only
 		}
 
-		bytes_queue = []; // Final clear of the queue before real operations start
-		reset(); // Reset state machine again to be absolutely sure
+		if (writer) {
+			await writer.write(command_bytes(FRONTEND_TO_BACKEND.SET_FRAME_MODE, FRAME_MODE));
+		}
 
 		status_message.set(`Device ready (Baud: ${BAUD}). Listening for data...`);
 		is_connected.set(true);
-		keep_reading = true;
 
-		if (reader) {
-			read_loop(); // Do not await, let it run in the background
-		} else {
-			// This case should ideally be caught by 'Serial port is not readable after boot wait.'
-			is_connected.set(false);
-			throw new Error('Reader not available to start read_loop.');
-		}
+		// The decoder starts from scratch in the worker
+		start_worker(port.readable);
 	} catch (error: any) {
 		status_message.set(`Error: ${error.message}`);
 		console.error('Serial connection error:', error);
@@ -307,11 +229,36 @@ export async function connect_to_serial_port() {
 		}
 		is_connected.set(false); // Ensure disconnected state
 		port = null; // Ensure port is nullified
-		reader = null;
 		writer = null;
 	}
 }
 
+// Command byte (bit 7 set) followed by its 7 bit data bytes
+function command_bytes(command: FRONTEND_TO_BACKEND, ...data: number[]): Uint8Array {
+	return new Uint8Array([command | (1 << 7), ...data.map((byte) => byte & ~(1 << 7))]);
+}
+
+export function send_command(command: FRONTEND_TO_BACKEND, ...data: number[]): Promise<boolean> {
+	return send_data(command_bytes(command, ...data));
+}
+
+// Held until released, like the physical button
+export function set_remote_fire(held: boolean) {
+	return send_command(FRONTEND_TO_BACKEND.BUTTON_PRESS, held ? 1 : 0);
+}
+
+// 10 bit value, as read from the potentiometer. Null gives the aim back to the potentiometer
+export function set_remote_aim(adc: number | null) {
+	if (adc == null) {
+		return send_command(FRONTEND_TO_BACKEND.RELEASE_AIM);
+	}
+	return send_command(FRONTEND_TO_BACKEND.SET_AIM, adc >> 7, adc & 0x7f);
+}
+
+export function set_paused(paused: boolean) {
+	return send_command(FRONTEND_TO_BACKEND.PAUSE, paused ? 1 : 0);
+}
+
 export async function send_data(data: Uint8Array): Promise<boolean> {
 	if (!writer || !_is_connected_internal) {
 		status_message.set('Not connected or writer not available.');
@@ -340,18 +287,8 @@ export async function send_data(data: Uint8Array): Promise<boolean> {
 
 async function disconnect_serial_port_internal() {
 	console.log('disconnect_serial_port_internal called');
-	keep_reading = false; // Signal read_loop to stop
-
-	if (reader) {
-		try {
-			await reader.cancel(); // This should make the read() in read_loop resolve with { done: true }
-			reader.releaseLock();
-			console.log('Reader cancelled and lock released.');
-		} catch (e: any) {
-			console.warn('Error cancelling or releasing reader:', e.message);
-		}
-		reader = null;
-	}
+	// The worker cancels its reader, which also unlocks port.readable for port.close()
+	await stop_worker();
 
 	if (writer) {
 		try {
@@ -402,10 +339,4 @@ export async function disconnect_serial_port() {
 		// Or set a generic "Ready to connect" message
 		status_message.set("Click 'Connect' to select the serial port.");
 	}
-	bytes_queue = []; // Clear queue on disconnect
-	reset(); // Reset state machine
 }
-
-// Small improvement to process() to make it non-recursive and avoid stack overflows on large data bursts
-// The original `process()` is now called by `process_async()` which handles the iteration.
-// The `if (bytes_queue.length > 0) { process(); }` at the end of `process()` is removed.
@@ -1,15 +1,24 @@
 c_file="src/generated.h"
 ts_file="frontend/src/lib/generated.ts"
+aim_table_file="src/game/aim_table.h"
+frame_tables_file="src/frame/frame_tables.h"
 
 # Define enums as associative arrays
-BACKEND_TO_FRONTEND_KEYS="FRAME_START FRAME_END BOOTED SCORE BULLETS"
+# FRAME_CHECK is followed by the CRC-8 of the frame data bytes as 2 data bytes (high bit, low 7
+# bits), FRAME_STATS by the sequence number, the time (ms), the tick and frame build times and the
+# wait for the previous frame (us) of the last frame, 14 bits as 2 data bytes
+BACKEND_TO_FRONTEND_KEYS="FRAME_START FRAME_END BOOTED SCORE BULLETS DELTA_FRAME_START RLE_RUN FRAME_CHECK FRAME_STATS"
 
-FRONTEND_TO_BACKEND_KEYS="BUTTON_PRESS"
+# Data bytes after each command: BUTTON_PRESS held (0/1), SET_FRAME_MODE mode, SET_AIM ADC value
+# (high 3 bits, low 7 bits), RELEASE_AIM none, PAUSE paused (0/1)
+FRONTEND_TO_BACKEND_KEYS="BUTTON_PRESS SET_FRAME_MODE SET_AIM RELEASE_AIM PAUSE"
 
 # Define variables
-VARIABLES_KEYS="SCREENX SCREENY BAUD BITS_PER_COLOR"
+# FRAME_MODE_*: flags sent after SET_FRAME_MODE
+# FRAME_CHECK_POLY: CRC-8 polynomial of FRAME_CHECK (x^8 + x^2 + x + 1), MSB first, initial value 0
+VARIABLES_KEYS="SCREENX SCREENY BAUD BITS_PER_COLOR FRAME_MODE_DELTA FRAME_MODE_RLE FRAME_MODE_CHECK FRAME_CHECK_POLY"
 # screen size x must be multiple of 12
-VARIABLES_VALUES="60 60 1000000 2"
+VARIABLES_VALUES="60 60 1000000 2 1 2 4 7"
 
 # Function to generate C enum
 generate_c_enum() {
@@ -65,9 +74,86 @@ generate_ts_constants() {
     echo "" >> "$ts_file"
 }
 
+# Aim lookup table: the 10 bit ADC reading is mapped to this many angles between 0 and PI
+AIM_TABLE_BITS=8
+
+# Function to generate a PROGMEM Q8.8 table of `fn(i * PI / (len - 1))`, fn being cos or sin
+generate_c_trig_table() {
+    local name="$1"
+    local fn="$2"
+    local len=$((1 << AIM_TABLE_BITS))
+
+    echo "static const fixed_t ${name}[AIM_TABLE_LEN] PROGMEM = {" >> "$aim_table_file"
+    awk -v len="$len" -v fn="$fn" 'BEGIN {
+        pi = atan2(0, -1);
+        for (i = 0; i < len; i++) {
+            angle = i * pi / (len - 1);
+            value = (fn == "cos" ? cos(angle) : sin(angle)) * 256;
+            value = value >= 0 ? int(value + 0.5) : -int(-value + 0.5);
+            printf "%s%d,", (i == 0 ? "    " : i % 12 == 0 ? "\n    " : " "), value;
+        }
+    }' >> "$aim_table_file"
+    echo "" >> "$aim_table_file"
+    echo "};" >> "$aim_table_file"
+    echo "" >> "$aim_table_file"
+}
+
+# Function to get the value of one of the VARIABLES_KEYS
+variable_value() {
+    local key_array=($VARIABLES_KEYS)
+    local value_array=($VARIABLES_VALUES)
+    for i in "${!key_array[@]}"; do
+        if [ "${key_array[$i]}" = "$1" ]; then
+            echo "${value_array[$i]}"
+        fi
+    done
+}
+
+# Function to generate a PROGMEM uint8_t table of `expr` for i in [0, len), `expr` being awk code
+generate_c_frame_table() {
+    local name="$1"
+    local len="$2"
+    local expr="$3"
+
+    echo "static const uint8_t ${name}[${len}] PROGMEM = {" >> "$frame_tables_file"
+    awk -v len="$len" "BEGIN {
+        for (i = 0; i < len; i++) {
+            printf \"%s%d,\", (i == 0 ? \"    \" : i % 12 == 0 ? \"\\n    \" : \" \"), ${expr};
+        }
+    }" >> "$frame_tables_file"
+    echo "" >> "$frame_tables_file"
+    echo "};" >> "$frame_tables_file"
+    echo "" >> "$frame_tables_file"
+}
+
+# Function to generate the PROGMEM CRC-8 table of FRAME_CHECK_POLY: the CRC of byte i, so that
+# crc = table[crc ^ byte] for each byte
+generate_c_crc_table() {
+    local name="$1"
+    local poly=$(variable_value FRAME_CHECK_POLY)
+
+    echo "static const uint8_t ${name}[256] PROGMEM = {" >> "$frame_tables_file"
+    local line="   "
+    for i in $(seq 0 255); do
+        local crc=$i
+        for bit in 1 2 3 4 5 6 7 8; do
+            crc=$(((crc & 0x80 ? crc << 1 ^ poly : crc << 1) & 0xFF))
+        done
+        line="${line} ${crc},"
+        if [ $((i % 12)) -eq 11 ] || [ "$i" -eq 255 ]; then
+            echo "$line" >> "$frame_tables_file"
+            line="   "
+        fi
+    done
+    echo "};" >> "$frame_tables_file"
+    echo "" >> "$frame_tables_file"
+}
+
 # Clear files
 > "$c_file"
 > "$ts_file"
+> "$aim_table_file"
+> "$frame_tables_file"
 
 # Generate C header
 echo "// THIS FILE IS AUTOGENERATED FROM generate-types.sh" >> "$c_file"
@@ -93,3 +179,54 @@ echo "" >> "$ts_file"
 generate_ts_constants "$VARIABLES_KEYS" "$VARIABLES_VALUES"
 generate_ts_enum "BACKEND_TO_FRONTEND" "$BACKEND_TO_FRONTEND_KEYS"
 generate_ts_enum "FRONTEND_TO_BACKEND" "$FRONTEND_TO_BACKEND_KEYS"
+
+# Generate aim table
+echo "// THIS FILE IS AUTOGENERATED FROM generate-types.sh" >> "$aim_table_file"
+echo "// DO NOT MODIFY MANUALLY" >> "$aim_table_file"
+echo "" >> "$aim_table_file"
+echo "#ifndef AIM_TABLE_H" >> "$aim_table_file"
+echo "#define AIM_TABLE_H" >> "$aim_table_file"
+echo "" >> "$aim_table_file"
+echo "#include \"../utils/utils.h\"" >> "$aim_table_file"
+echo "#include \"fixed.h\"" >> "$aim_table_file"
+echo "" >> "$aim_table_file"
+echo "#define AIM_TABLE_BITS ${AIM_TABLE_BITS}" >> "$aim_table_file"
+echo "#define AIM_TABLE_LEN (1 << AIM_TABLE_BITS)" >> "$aim_table_file"
+echo "" >> "$aim_table_file"
+echo "// Q8.8 cos/sin of i * PI / (AIM_TABLE_LEN - 1)" >> "$aim_table_file"
+generate_c_trig_table "aim_cos_table" "cos"
+generate_c_trig_table "aim_sin_table" "sin"
+echo "#endif" >> "$aim_table_file"
+
+# Generate frame tables: the pixel -> cell packing of the frame encoder, specialised for the screen
+# size and color depth, so that it needs no division, modulo or variable shift
+SCREENX=$(variable_value SCREENX)
+BITS_PER_COLOR=$(variable_value BITS_PER_COLOR)
+# One bit is reserved for command/data mode
+COLORS_PER_BYTE=$(((8 - 1) / BITS_PER_COLOR))
+COLORS=$((1 << BITS_PER_COLOR))
+
+echo "// THIS FILE IS AUTOGENERATED FROM generate-types.sh" >> "$frame_tables_file"
+echo "// DO NOT MODIFY MANUALLY" >> "$frame_tables_file"
+echo "" >> "$frame_tables_file"
+echo "#ifndef FRAME_TABLES_H" >> "$frame_tables_file"
+echo "#define FRAME_TABLES_H" >> "$frame_tables_file"
+echo "" >> "$frame_tables_file"
+echo "#include \"../utils/utils.h\"" >> "$frame_tables_file"
+echo "#include <stdint.h>" >> "$frame_tables_file"
+echo "" >> "$frame_tables_file"
+echo "// Configuration the tables were generated for" >> "$frame_tables_file"
+echo "#define FRAME_TABLES_SCREENX ${SCREENX}" >> "$frame_tables_file"
+echo "#define FRAME_TABLES_BITS_PER_COLOR ${BITS_PER_COLOR}" >> "$frame_tables_file"
+echo "" >> "$frame_tables_file"
+echo "// Cell column of pixel x: x / COLORS_PER_BYTE" >> "$frame_tables_file"
+generate_c_frame_table "frame_col_table" "$SCREENX" "int(i / ${COLORS_PER_BYTE})"
+echo "// Row of pixel x in frame_value_table: (x % COLORS_PER_BYTE) * (1 << BITS_PER_COLOR)" >> "$frame_tables_file"
+generate_c_frame_table "frame_slot_table" "$SCREENX" "(i % ${COLORS_PER_BYTE}) * ${COLORS}"
+echo "// Cell bits of a color in each slot: color << (BITS_PER_COLOR * slot)," >> "$frame_tables_file"
+echo "// indexed by frame_slot_table[x] + color" >> "$frame_tables_file"
+generate_c_frame_table "frame_value_table" "$((COLORS_PER_BYTE * COLORS))" \
+    "(i % ${COLORS}) * 2 ^ (${BITS_PER_COLOR} * int(i / ${COLORS}))"
+echo "// CRC-8 of FRAME_CHECK_POLY, indexed by crc ^ data byte" >> "$frame_tables_file"
+generate_c_crc_table "frame_crc_table"
+echo "#endif" >> "$frame_tables_file"
@@ -0,0 +1,127 @@
+// Deterministic benchmark of the game logic on the host machine.
+//
+// Replays a scripted input sequence (a potentiometer sweep and a fire button pattern) with a fixed
+// simulated frame time, and measures process_tick() and the frame encoding separately.
+//
+// Usage: bench [ticks] [frame mode] [record|replay <file>]
+// `frame mode` is a combination of the FRAME_MODE_* flags, see generated.h.
+// `record` saves the inputs of the run, `replay` runs the inputs of a saved log instead of the
+// script (see replay.h): the serial hash tells whether two runs sent exactly the same frames
+
+#include "frame/frame.h"
+#include "game/game.h"
+#include "generated.h"
+#include "host.h"
+#include "replay.h"
+#include "serial/serial.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_TICKS 100000
+// Simulated time between ticks, ~60 fps
+#define TICK_MS 16
+// The potentiometer goes from one end to the other in this many ticks
+#define SWEEP_TICKS 180
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Triangle wave over the whole 10-bit ADC range
+static uint16_t scripted_angle(uint32_t tick) {
+    uint32_t phase = tick % (2 * SWEEP_TICKS);
+    if (phase >= SWEEP_TICKS) {
+        phase = 2 * SWEEP_TICKS - phase;
+    }
+    return phase * ((1 << 10) - 1) / SWEEP_TICKS;
+}
+
+// Hold the button for 3 ticks out of 4
+static boolean scripted_button(uint32_t tick) {
+    return (tick % 4) != 3;
+}
+
+int main(int argc, char **argv) {
+    uint32_t ticks = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_TICKS;
+    uint8_t  mode  = argc > 2 ? strtoul(argv[2], 0, 10) : FRAME_MODE_DELTA;
+
+    boolean recording = false;
+    boolean replaying = false;
+    if (argc > 4) {
+        recording = strcmp(argv[3], "record") == 0 && replay_record_open(argv[4]);
+        replaying = strcmp(argv[3], "replay") == 0 && replay_play_open(argv[4]);
+        if (!recording && !replaying) {
+            fprintf(stderr, "cannot %s %s\n", argv[3], argv[4]);
+            return 1;
+        }
+    }
+
+    uint64_t tick_ns   = 0;
+    uint64_t encode_ns = 0;
+    uint32_t games     = 1;
+
+    jmp_buf error_handler;
+    host_error_handler = &error_handler;
+
+    init_game();
+    frame_set_mode(mode);
+    host_current_ms = 1;
+    host_reset_serial_counters();
+
+    volatile uint32_t tick;
+    for (tick = 0; tick < ticks; tick++) {
+        if (setjmp(error_handler)) {
+            if (host_last_error != LOSER) {
+                fprintf(stderr, "throw_error(%d) at tick %u\n", host_last_error, tick);
+                return 1;
+            }
+            // A parachute landed: start a new game and keep going
+            init_game();
+            games++;
+            continue;
+        }
+
+        replay_input_t input = {TICK_MS, scripted_angle(tick), scripted_button(tick)};
+        if (replaying && !replay_next(&input)) {
+            break;
+        }
+        if (recording) {
+            replay_record(&input);
+        }
+
+        host_current_ms += input.elapsed_ms;
+
+        aim_t aim = aim_from_adc(input.aim_adc);
+
+        uint64_t start = now_ns();
+        process_tick(host_current_ms, aim, input.button);
+        uint64_t ticked = now_ns();
+        start_sending_frame();
+        serial_out_join();
+        uint64_t encoded = now_ns();
+
+        tick_ns += ticked - start;
+        encode_ns += encoded - ticked;
+    }
+
+    replay_close();
+    // A replay can be shorter than asked
+    ticks = tick;
+
+    printf("screen:          %dx%d, %d bits per color\n", SCREENX, SCREENY, BITS_PER_COLOR);
+    printf("frame mode:      %s%s%s\n",
+           mode & FRAME_MODE_DELTA ? "delta " : "",
+           mode & FRAME_MODE_RLE ? "rle " : "",
+           mode & FRAME_MODE_CHECK ? "check" : "");
+    printf("ticks:           %u (%u games)\n", ticks, games);
+    printf("ns per tick:     %.1f\n", (double) tick_ns / ticks);
+    printf("ns per encode:   %.1f\n", (double) encode_ns / ticks);
+    printf("bytes per frame: %.1f\n", (double) host_serial_bytes / ticks);
+    printf("serial hash:     %08x\n", host_serial_hash);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "host.h"
+#include "serial/serial.h"
+#include "timers/timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Whole data space of the atmega328p registers, EXPAND_ADDRESS points in here
+volatile uint8_t host_registers[0x100];
+
+uint32_t host_current_ms = 0;
+
+jmp_buf *host_error_handler = 0;
+ERROR    host_last_error    = ALL_GOOD;
+
+// FNV-1a, 32 bits
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME  16777619u
+
+uint32_t host_serial_bytes = 0;
+uint32_t host_serial_hash  = FNV_OFFSET;
+
+// Keeps the compiler from optimizing away the generated bytes
+volatile uint8_t host_serial_sink;
+
+void host_reset_serial_counters() {
+    host_serial_bytes = 0;
+    host_serial_hash  = FNV_OFFSET;
+}
+
+static void host_serial_out(uint8_t data) {
+    host_serial_sink = data;
+    host_serial_hash = (host_serial_hash ^ data) * FNV_PRIME;
+    host_serial_bytes++;
+}
+
+// Utils
+
+void throw_error(ERROR error_kind) {
+    host_last_error = error_kind;
+    if (host_error_handler) {
+        longjmp(*host_error_handler, 1);
+    }
+
+    fprintf(stderr, "throw_error(%d)\n", error_kind);
+    exit(error_kind);
+}
+
+void sleep() {}
+
+void wait() {}
+
+// Timers
+
+uint32_t get_current_ms() {
+    return host_current_ms;
+}
+
+uint32_t get_current_us() {
+    return host_current_ms * 1000;
+}
+
+uint32_t get_current_time() {
+    return host_current_ms;
+}
+
+void sleep_ms(uint32_t ms) {
+    host_current_ms += ms;
+}
+
+// Serial: everything is "transmitted" immediately
+
+void send_data(uint8_t *buffer, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        host_serial_out(buffer[i]);
+    }
+}
+
+void send_data_generator_f(volatile boolean f(uint8_t *)) {
+    uint8_t data;
+    while (f(&data)) {
+        host_serial_out(data);
+    }
+}
+
+void serial_out_join() {}
@@ -0,0 +1,25 @@
+#ifndef _HOST_H
+#define _HOST_H
+
+// Stubs that replace the hardware-facing modules when building the game logic for the host
+// machine. Compile with -DHOST, see bench.sh
+
+#include "utils/utils.h"
+#include <setjmp.h>
+#include <stdint.h>
+
+// Simulated clock, returned by get_current_ms() and get_current_time()
+extern uint32_t host_current_ms;
+
+// If set, throw_error() jumps here instead of terminating the process
+extern jmp_buf *host_error_handler;
+extern ERROR    host_last_error;
+
+// Bytes pushed through the serial stubs since the last reset, and their hash: two runs that send
+// the same frames have the same hash
+extern uint32_t host_serial_bytes;
+extern uint32_t host_serial_hash;
+
+void host_reset_serial_counters();
+
+#endif
@@ -0,0 +1,226 @@
+// Checks the Q8.8 physics against the float reference.
+//
+// The same source is built twice. The float build (-DFLOAT_PHYSICS) runs scripted games and writes
+// every entity position after every simulation step; the fixed-point build runs the same script,
+// reads the trace back and fails as soon as one of its entities is more than TOLERANCE_PX away
+// from its float counterpart. See check.sh
+//
+// Even within tolerance, a projectile can leave the screen one step earlier in one build. The
+// entities are matched by position, not by index, and steps where the entity counts differ are
+// skipped. A hit in one build only makes the games differ for good: the script is cut in rounds
+// that each start a new game, a round is compared up to such a divergence, and the check fails if
+// less than MIN_COMPARED_PERCENT of the steps could be compared.
+//
+// Usage: physics_check write|compare <trace file> [steps]
+
+#include "game/entities.h"
+#include "game/game.h"
+#include "host.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ~1 minute of game, in rounds of 5 s
+#define DEFAULT_STEPS (60 * SIM_HZ)
+#define ROUND_STEPS   (5 * SIM_HZ)
+// Largest distance between a fixed-point position and its float reference, on either axis
+#define TOLERANCE_PX 0.1f
+// Entity counts can differ for a step when an entity leaves the screen, longer is a divergence
+#define MAX_MISMATCH_STEPS 2
+// Below this, the builds diverge too early for the check to mean anything
+#define MIN_COMPARED_PERCENT 75
+// The aim goes from one end to the other in this many steps
+#define SWEEP_STEPS (3 * SIM_HZ)
+// Hold the button for 3 periods out of 4
+#define BUTTON_STEPS (SIM_HZ / 5)
+
+#ifdef FLOAT_PHYSICS
+    #define PIXELS(x) (x)
+#else
+    #define PIXELS(x) ((float) (x) / FIXED_ONE)
+#endif
+
+typedef struct {
+    float   x;
+    float   y;
+    boolean matched;
+} position_t;
+
+// Rounded to Q8.8 in both builds: the aim table is not what is being checked
+static aim_t scripted_aim(uint32_t step) {
+    uint32_t phase = step % (2 * SWEEP_STEPS);
+    if (phase >= SWEEP_STEPS) {
+        phase = 2 * SWEEP_STEPS - phase;
+    }
+    float angle = (float) M_PI * phase / SWEEP_STEPS;
+    return (aim_t) {.x = SCALAR_RATIO(lroundf(cosf(angle) * 256), 256),
+                    .y = SCALAR_RATIO(lroundf(sinf(angle) * 256), 256)};
+}
+
+static boolean scripted_button(uint32_t step) {
+    return (step / BUTTON_STEPS) % 4 != 3;
+}
+
+static FILE *trace;
+static float max_error = 0;
+
+static void write_positions(scalar_t *pos_x, scalar_t *pos_y, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+        fprintf(trace, "%.6f %.6f\n", PIXELS(pos_x[i]), PIXELS(pos_y[i]));
+    }
+}
+
+static boolean read_positions(position_t *positions, unsigned len) {
+    for (unsigned i = 0; i < len; i++) {
+        if (fscanf(trace, "%f %f", &positions[i].x, &positions[i].y) != 2) {
+            return false;
+        }
+        positions[i].matched = false;
+    }
+    return true;
+}
+
+// False if an entity has no float counterpart within tolerance. Both lists have `len` entities
+static boolean match_positions(scalar_t   *pos_x,
+                               scalar_t   *pos_y,
+                               uint8_t     len,
+                               position_t *expected) {
+    for (uint8_t i = 0; i < len; i++) {
+        position_t *closest = 0;
+        float       error   = INFINITY;
+        for (uint8_t j = 0; j < len; j++) {
+            float distance = fmaxf(fabsf(PIXELS(pos_x[i]) - expected[j].x),
+                                   fabsf(PIXELS(pos_y[i]) - expected[j].y));
+            if (!expected[j].matched && distance < error) {
+                closest = &expected[j];
+                error   = distance;
+            }
+        }
+
+        if (error > max_error) {
+            max_error = error;
+        }
+        if (!closest || error > TOLERANCE_PX) {
+            return false;
+        }
+        closest->matched = true;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || (strcmp(argv[1], "write") != 0 && strcmp(argv[1], "compare") != 0)) {
+        fprintf(stderr, "Usage: %s write|compare <trace file> [steps]\n", argv[0]);
+        return 1;
+    }
+    boolean  writing = strcmp(argv[1], "write") == 0;
+    uint32_t steps   = argc > 3 ? strtoul(argv[3], 0, 10) : DEFAULT_STEPS;
+
+    trace = fopen(argv[2], writing ? "w" : "r");
+    if (!trace) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    position_t expected_projectiles[MAX_PROJECTILES];
+    position_t expected_parachutes[MAX_PARACHUTES];
+
+    jmp_buf error_handler;
+    host_error_handler = &error_handler;
+
+    volatile uint32_t games    = 0;
+    volatile uint32_t rounds   = 0;
+    volatile uint32_t diverged = 0;
+    volatile uint32_t compared = 0;
+    // Consecutive steps with different entity counts in the current round
+    volatile uint8_t mismatch_steps = 0;
+
+    volatile uint32_t step;
+    for (step = 0; step < steps; step++) {
+        if (setjmp(error_handler)) {
+            if (host_last_error != LOSER) {
+                fprintf(stderr, "throw_error(%d) at step %u\n", host_last_error, step);
+                return 1;
+            }
+            init_game();
+            games++;
+        }
+        if (step % ROUND_STEPS == 0) {
+            init_game();
+            games++;
+            rounds++;
+            mismatch_steps = 0;
+        }
+
+        simulate_step(scripted_aim(step), scripted_button(step));
+
+        if (writing) {
+            fprintf(trace, "%u %u %u %u\n", games, score, projectiles.len, parachutes.len);
+            write_positions(projectiles.pos_x, projectiles.pos_y, projectiles.len);
+            write_positions(parachutes.pos_x, parachutes.pos_y, parachutes.len);
+            continue;
+        }
+
+        unsigned expected_games, expected_score, expected_projectiles_len, expected_parachutes_len;
+        if (fscanf(trace,
+                   "%u %u %u %u",
+                   &expected_games,
+                   &expected_score,
+                   &expected_projectiles_len,
+                   &expected_parachutes_len) != 4 ||
+            expected_projectiles_len > MAX_PROJECTILES ||
+            expected_parachutes_len > MAX_PARACHUTES ||
+            !read_positions(expected_projectiles, expected_projectiles_len) ||
+            !read_positions(expected_parachutes, expected_parachutes_len)) {
+            fprintf(stderr, "Bad or short trace at step %u\n", step);
+            return 1;
+        }
+
+        if (mismatch_steps > MAX_MISMATCH_STEPS) {
+            // The round has diverged
+            continue;
+        }
+        if (expected_games != games || expected_score != score ||
+            expected_projectiles_len != projectiles.len ||
+            expected_parachutes_len != parachutes.len) {
+            if (++mismatch_steps > MAX_MISMATCH_STEPS) {
+                diverged++;
+            }
+            continue;
+        }
+        mismatch_steps = 0;
+
+        if (!match_positions(
+                projectiles.pos_x, projectiles.pos_y, projectiles.len, expected_projectiles) ||
+            !match_positions(
+                parachutes.pos_x, parachutes.pos_y, parachutes.len, expected_parachutes)) {
+            fprintf(stderr,
+                    "Step %u: an entity is %.4f px away from the float one, tolerance %.2f px\n",
+                    step,
+                    max_error,
+                    TOLERANCE_PX);
+            return 1;
+        }
+        compared++;
+    }
+
+    fclose(trace);
+    if (writing) {
+        return 0;
+    }
+
+    printf("%u of %u steps within %.2f px of the float physics (max %.4f px), %u of %u rounds "
+           "diverged\n",
+           compared,
+           steps,
+           TOLERANCE_PX,
+           max_error,
+           diverged,
+           rounds);
+    if (compared * 100 < steps * MIN_COMPARED_PERCENT) {
+        fprintf(stderr, "Less than %d%% of the steps could be compared\n", MIN_COMPARED_PERCENT);
+        return 1;
+    }
+    return 0;
+}
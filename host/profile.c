@@ -0,0 +1,371 @@
+// Cycle-accurate profiler for the firmware, built on simavr.
+//
+// Runs the firmware ELF instruction by instruction, injecting a potentiometer sweep on ADC1 and a
+// fire button pattern on PIND4, and attributes every cycle to the function containing the program
+// counter (ISRs show up as their __vector_N). A minimal I2C slave acks the LCD so that init does
+// not hang.
+//
+// Frames are delimited by their FRAME_START or DELTA_FRAME_START command on the USART. Once the
+// firmware has booted, the profiler sends it SET_FRAME_MODE like the frontend does.
+//
+// Usage: profile <firmware.elf> <symbols> [frames] [frame mode]
+// `symbols` is the output of `avr-nm -n --defined-only firmware.elf`, `frame mode` a combination
+// of the FRAME_MODE_* flags (same default as the frontend)
+
+#include "generated.h"
+#include <simavr/avr_adc.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_twi.h>
+#include <simavr/avr_uart.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MCU       "atmega328p"
+#define FREQUENCY 16000000
+#define AVCC_MV   5000
+
+// Cycles available per frame at the 60 fps target
+#define FRAME_BUDGET (FREQUENCY / 60)
+
+#define LCD_I2C_ADDRESS 0x27
+#define SHOOT_PIN       4
+#define AIM_ADC_CHANNEL 1
+
+// Stimuli, same shape as bench.c but in simulated time
+#define SWEEP_MS       3000
+#define BUTTON_MS      200
+#define DEFAULT_FRAMES 120
+// Give up if no frame is produced for this long
+#define MAX_MS_WITHOUT_FRAME 2000
+
+#define FRAME_START_BYTE       (FRAME_START | 1 << 7)
+#define DELTA_FRAME_START_BYTE (DELTA_FRAME_START | 1 << 7)
+#define FRAME_END_BYTE         (FRAME_END | 1 << 7)
+#define BOOTED_BYTE            (BOOTED | 1 << 7)
+#define SET_FRAME_MODE_BYTE    (SET_FRAME_MODE | 1 << 7)
+#define DEFAULT_FRAME_MODE     (FRAME_MODE_DELTA | FRAME_MODE_RLE | FRAME_MODE_CHECK)
+
+#define MAX_SYMBOLS       1024
+#define MAX_FRAMES        4096
+#define SLEEP_SYMBOL_NAME "<sleep>"
+
+typedef struct {
+    uint32_t address;
+    char     name[64];
+    uint64_t cycles;
+} symbol_t;
+
+typedef struct {
+    uint64_t start_cycle;
+    uint64_t busy_cycles;
+    // From the start command to FRAME_END included
+    uint32_t bytes;
+    uint8_t  keyframe;
+} frame_t;
+
+symbol_t symbols[MAX_SYMBOLS];
+uint32_t symbols_len = 0;
+// Cycles spent sleeping and outside any known symbol
+uint64_t sleep_cycles   = 0;
+uint64_t unknown_cycles = 0;
+
+frame_t  frames[MAX_FRAMES];
+uint32_t frames_len = 0;
+// Between the start of the last frame and its FRAME_END
+uint8_t in_frame = 0;
+
+uint8_t frame_mode = DEFAULT_FRAME_MODE;
+
+avr_t  *avr;
+uint8_t lcd_selected = 0;
+
+int compare_symbols(const void *a, const void *b) {
+    const symbol_t *sa = a;
+    const symbol_t *sb = b;
+    return (sa->address > sb->address) - (sa->address < sb->address);
+}
+
+// Only keeps text symbols, data symbols live in a different address space
+void load_symbols(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(1);
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) && symbols_len < MAX_SYMBOLS) {
+        unsigned int address;
+        char         type;
+        char         name[64];
+        if (sscanf(line, "%x %c %63s", &address, &type, name) != 3) {
+            continue;
+        }
+        if (type != 'T' && type != 't' && type != 'W' && type != 'w') {
+            continue;
+        }
+        symbols[symbols_len].address = address;
+        strcpy(symbols[symbols_len].name, name);
+        symbols_len++;
+    }
+    fclose(file);
+
+    qsort(symbols, symbols_len, sizeof(symbol_t), compare_symbols);
+}
+
+// Last symbol starting at or before `pc`
+symbol_t *find_symbol(uint32_t pc) {
+    int32_t low  = 0;
+    int32_t high = symbols_len - 1;
+    int32_t best = -1;
+    while (low <= high) {
+        int32_t mid = (low + high) / 2;
+        if (symbols[mid].address <= pc) {
+            best = mid;
+            low  = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return best < 0 ? 0 : &symbols[best];
+}
+
+void uart_out_hook(struct avr_irq_t *irq, uint32_t value, void *param) {
+    if (value == BOOTED_BYTE) {
+        // Same handshake as the frontend, the firmware only sends keyframes until then
+        avr_irq_t *uart_in = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+        avr_raise_irq(uart_in, SET_FRAME_MODE_BYTE);
+        avr_raise_irq(uart_in, frame_mode);
+        return;
+    }
+
+    if ((value == FRAME_START_BYTE || value == DELTA_FRAME_START_BYTE) &&
+        frames_len < MAX_FRAMES) {
+        frames[frames_len].start_cycle = avr->cycle;
+        frames[frames_len].busy_cycles = 0;
+        frames[frames_len].bytes       = 0;
+        frames[frames_len].keyframe    = value == FRAME_START_BYTE;
+        frames_len++;
+        in_frame = 1;
+    }
+    if (in_frame) {
+        frames[frames_len - 1].bytes++;
+        in_frame = value != FRAME_END_BYTE;
+    }
+}
+
+// Acks every START and data byte addressed to the LCD backpack
+void twi_out_hook(struct avr_irq_t *irq, uint32_t value, void *param) {
+    avr_irq_t        *twi_in = param;
+    avr_twi_msg_irq_t msg;
+    msg.u.v = value;
+
+    if (msg.u.twi.msg & TWI_COND_STOP) {
+        lcd_selected = 0;
+    }
+    if (msg.u.twi.msg & TWI_COND_START) {
+        lcd_selected = 0;
+        if ((msg.u.twi.addr >> 1) == LCD_I2C_ADDRESS) {
+            lcd_selected = msg.u.twi.addr;
+            avr_raise_irq(twi_in, avr_twi_irq_msg(TWI_COND_ACK, lcd_selected, 1));
+        }
+    }
+    if (lcd_selected && (msg.u.twi.msg & TWI_COND_WRITE)) {
+        avr_raise_irq(twi_in, avr_twi_irq_msg(TWI_COND_ACK, lcd_selected, 1));
+    }
+}
+
+void apply_stimuli(uint32_t ms) {
+    uint32_t phase = ms % (2 * SWEEP_MS);
+    if (phase >= SWEEP_MS) {
+        phase = 2 * SWEEP_MS - phase;
+    }
+    uint32_t millivolts = phase * AVCC_MV / SWEEP_MS;
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + AIM_ADC_CHANNEL),
+                  millivolts);
+
+    // Active low, pressed 3 periods out of 4
+    uint8_t pressed = (ms / BUTTON_MS) % 4 != 3;
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), SHOOT_PIN), !pressed);
+}
+
+void print_report() {
+    uint64_t total = sleep_cycles + unknown_cycles;
+    for (uint32_t i = 0; i < symbols_len; i++) {
+        total += symbols[i].cycles;
+    }
+
+    // Sort by cycles, descending
+    for (uint32_t i = 0; i < symbols_len; i++) {
+        for (uint32_t j = i + 1; j < symbols_len; j++) {
+            if (symbols[j].cycles > symbols[i].cycles) {
+                symbol_t temp = symbols[i];
+                symbols[i]    = symbols[j];
+                symbols[j]    = temp;
+            }
+        }
+    }
+
+    // Only complete frames (between two frame starts) are meaningful
+    uint32_t complete_frames = frames_len > 1 ? frames_len - 1 : 0;
+
+    printf("Cycles per symbol (%llu total, %.1f ms simulated)\n",
+           (unsigned long long) total,
+           total * 1000.0 / FREQUENCY);
+    printf("%-32s %14s %7s %14s\n", "symbol", "cycles", "%", "per frame");
+    for (uint32_t i = 0; i < symbols_len && symbols[i].cycles; i++) {
+        printf("%-32s %14llu %6.2f%% %14.0f\n",
+               symbols[i].name,
+               (unsigned long long) symbols[i].cycles,
+               100.0 * symbols[i].cycles / total,
+               frames_len ? (double) symbols[i].cycles / frames_len : 0);
+    }
+    printf("%-32s %14llu %6.2f%%\n",
+           SLEEP_SYMBOL_NAME,
+           (unsigned long long) sleep_cycles,
+           100.0 * sleep_cycles / total);
+    if (unknown_cycles) {
+        printf("%-32s %14llu %6.2f%%\n",
+               "<unknown>",
+               (unsigned long long) unknown_cycles,
+               100.0 * unknown_cycles / total);
+    }
+
+    printf("\nCycles per frame (budget %d cycles at 60 fps, frame mode %d)\n",
+           FRAME_BUDGET,
+           frame_mode);
+    printf("%6s %6s %6s %12s %12s %8s\n", "frame", "kind", "bytes", "cycles", "busy", "budget");
+    uint64_t worst = 0;
+    uint64_t sum   = 0;
+    // Keyframes and delta frames have very different sizes, averaged separately
+    uint32_t kind_frames[2] = {0, 0};
+    uint64_t kind_bytes[2]  = {0, 0};
+    for (uint32_t i = 0; i < complete_frames; i++) {
+        uint64_t cycles = frames[i + 1].start_cycle - frames[i].start_cycle;
+        printf("%6u %6s %6u %12llu %12llu %7.1f%%%s\n",
+               i,
+               frames[i].keyframe ? "key" : "delta",
+               frames[i].bytes,
+               (unsigned long long) cycles,
+               (unsigned long long) frames[i].busy_cycles,
+               100.0 * cycles / FRAME_BUDGET,
+               cycles > FRAME_BUDGET ? "  OVER" : "");
+        sum += cycles;
+        if (cycles > worst) {
+            worst = cycles;
+        }
+        kind_frames[frames[i].keyframe]++;
+        kind_bytes[frames[i].keyframe] += frames[i].bytes;
+    }
+    if (complete_frames) {
+        printf("\naverage %llu cycles (%.1f fps), worst %llu cycles (%.1f fps)\n",
+               (unsigned long long) (sum / complete_frames),
+               (double) FREQUENCY * complete_frames / sum,
+               (unsigned long long) worst,
+               (double) FREQUENCY / worst);
+        printf("keyframes:    %u, %.1f bytes each\n",
+               kind_frames[1],
+               kind_frames[1] ? (double) kind_bytes[1] / kind_frames[1] : 0);
+        printf("delta frames: %u, %.1f bytes each\n",
+               kind_frames[0],
+               kind_frames[0] ? (double) kind_bytes[0] / kind_frames[0] : 0);
+    } else {
+        printf("less than two frames were sent, no frame budget available\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <firmware.elf> <symbols> [frames] [frame mode]\n", argv[0]);
+        return 1;
+    }
+    uint32_t max_frames = argc > 3 ? strtoul(argv[3], 0, 10) : DEFAULT_FRAMES;
+    if (argc > 4) {
+        frame_mode = strtoul(argv[4], 0, 10);
+    }
+
+    load_symbols(argv[2]);
+
+    elf_firmware_t firmware = {{0}};
+    if (elf_read_firmware(argv[1], &firmware)) {
+        fprintf(stderr, "Unable to load %s\n", argv[1]);
+        return 1;
+    }
+    // The firmware does not embed the simavr mcu section
+    strcpy(firmware.mmcu, MCU);
+    firmware.frequency = FREQUENCY;
+    firmware.avcc      = AVCC_MV;
+    firmware.aref      = AVCC_MV;
+
+    avr = avr_make_mcu_by_name(firmware.mmcu);
+    if (!avr) {
+        fprintf(stderr, "Unknown mcu %s\n", firmware.mmcu);
+        return 1;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+
+    // Keep the frame bytes off the terminal
+    uint32_t uart_flags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uart_flags);
+    uart_flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uart_flags);
+    avr_irq_register_notify(
+        avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uart_out_hook, 0);
+
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT),
+                            twi_out_hook,
+                            avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+
+    uint32_t last_stimuli_ms = UINT32_MAX;
+    uint64_t frame_timeout   = (uint64_t) MAX_MS_WITHOUT_FRAME * FREQUENCY / 1000;
+    int      state           = cpu_Running;
+
+    while (state != cpu_Done && state != cpu_Crashed && frames_len <= max_frames) {
+        uint32_t ms = avr->cycle * 1000 / FREQUENCY;
+        if (ms != last_stimuli_ms) {
+            apply_stimuli(ms);
+            last_stimuli_ms = ms;
+        }
+
+        uint64_t last_frame_cycle = frames_len ? frames[frames_len - 1].start_cycle : 0;
+        if (avr->cycle - last_frame_cycle > frame_timeout) {
+            fprintf(stderr, "No frame for %d ms, stopping\n", MAX_MS_WITHOUT_FRAME);
+            break;
+        }
+
+        uint32_t pc       = avr->pc;
+        uint8_t  sleeping = avr->state == cpu_Sleeping;
+        uint64_t before   = avr->cycle;
+
+        state = avr_run(avr);
+
+        uint64_t spent = avr->cycle - before;
+        if (sleeping) {
+            sleep_cycles += spent;
+            continue;
+        }
+
+        symbol_t *symbol = find_symbol(pc);
+        if (symbol) {
+            symbol->cycles += spent;
+        } else {
+            unknown_cycles += spent;
+        }
+        if (frames_len) {
+            frames[frames_len - 1].busy_cycles += spent;
+        }
+    }
+
+    if (state == cpu_Crashed) {
+        fprintf(stderr, "The firmware crashed at pc 0x%04x\n", avr->pc);
+    }
+
+    print_report();
+    return state == cpu_Crashed;
+}
@@ -0,0 +1,97 @@
+// Stress test of the DECLARE_QUEUE ring with real concurrency.
+//
+// One producer thread and one consumer thread push a few million sequence numbers through a small
+// queue, mixing single and batched calls so that the batches wrap around the end of the buffer.
+// The consumer fails on the first value that is missing, duplicated or out of order.
+// Build with CFLAGS=-fsanitize=thread to also check the memory ordering, see check.sh
+//
+// Usage: queue_stress [items]
+
+#include "gen_queue.h"
+#include "utils/utils.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_ITEMS 4000000
+// Small, so that the queue is often full and often empty
+#define QUEUE_SIZE 16
+// Batches go up to a whole queue
+#define MAX_BATCH QUEUE_SIZE
+
+DECLARE_QUEUE(stress, uint32_t, QUEUE_SIZE);
+
+static uint32_t items;
+
+static void *produce(void *arg) {
+    uint32_t batch[MAX_BATCH];
+    uint32_t next = 0;
+    while (next < items) {
+        // Every other call is a batch, of a length that keeps changing
+        uint8_t len = next % 2 ? 1 + next % MAX_BATCH : 0;
+        if (len > items - next) {
+            len = items - next;
+        }
+
+        if (len == 0) {
+            if (stress_enqueue(next)) {
+                next++;
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        for (uint8_t i = 0; i < len; i++) {
+            batch[i] = next + i;
+        }
+        if (stress_enqueue_n(batch, len)) {
+            next += len;
+        } else {
+            // Full: let the consumer run, there might be a single core
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+static void *consume(void *arg) {
+    uint32_t batch[MAX_BATCH];
+    uint32_t expected = 0;
+    while (expected < items) {
+        uint8_t len;
+        if (expected % 3 == 0) {
+            len = stress_dequeue(batch) ? 1 : 0;
+        } else {
+            len = stress_dequeue_n(batch, 1 + expected % MAX_BATCH);
+        }
+        if (len == 0) {
+            sched_yield();
+        }
+
+        for (uint8_t i = 0; i < len; i++, expected++) {
+            if (batch[i] != expected) {
+                fprintf(stderr, "Expected %u, dequeued %u\n", expected, batch[i]);
+                exit(1);
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    items = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_ITEMS;
+
+    pthread_t producer, consumer;
+    pthread_create(&consumer, 0, consume, 0);
+    pthread_create(&producer, 0, produce, 0);
+    pthread_join(producer, 0);
+    pthread_join(consumer, 0);
+
+    if (!stress_empty()) {
+        fprintf(stderr, "%u items left in the queue\n", stress_len());
+        return 1;
+    }
+    printf("%u items through a %d slot queue, in order and none lost\n", items, QUEUE_SIZE);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+FILE *replay_file = 0;
+
+boolean replay_record_open(const char *path) {
+    replay_file = fopen(path, "w");
+    return replay_file != 0;
+}
+
+boolean replay_play_open(const char *path) {
+    replay_file = fopen(path, "r");
+    return replay_file != 0;
+}
+
+void replay_record(const replay_input_t *input) {
+    fprintf(replay_file, "%u %u %u\n", input->elapsed_ms, input->aim_adc, input->button);
+}
+
+boolean replay_next(replay_input_t *input) {
+    unsigned elapsed_ms, aim_adc, button;
+    if (fscanf(replay_file, "%u %u %u", &elapsed_ms, &aim_adc, &button) != 3) {
+        return false;
+    }
+
+    input->elapsed_ms = elapsed_ms;
+    input->aim_adc    = aim_adc;
+    input->button     = button != 0;
+    return true;
+}
+
+void replay_close() {
+    if (replay_file) {
+        fclose(replay_file);
+        replay_file = 0;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+// Input log for deterministic replays, one line per tick: "<elapsed ms> <aim ADC> <button>".
+//
+// The simulation runs at a fixed step and only depends on these inputs: replaying a log gives the
+// same game, step by step, on any machine and whatever the speed of the benchmark
+
+#include "utils/utils.h"
+#include <stdint.h>
+
+typedef struct {
+    // Since the previous tick
+    uint16_t elapsed_ms;
+    uint16_t aim_adc;
+    boolean  button;
+} replay_input_t;
+
+// Return false if the file cannot be opened
+boolean replay_record_open(const char *path);
+boolean replay_play_open(const char *path);
+
+void replay_record(const replay_input_t *input);
+// False at the end of the log
+boolean replay_next(replay_input_t *input);
+
+void replay_close();
+
+#endif
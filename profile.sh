@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Compiles the firmware and runs it in simavr (no board needed), printing the cycles spent in every
+# function and the cycles used by every frame against the 60 fps budget.
+#
+# Usage: ./profile.sh [frames] [frame mode]
+
+# Exit on any error
+set -e
+
+# Configuration, keep in sync with flash.sh
+MCU="atmega328p"
+F_CPU="16000000UL"
+TARGET="firmware"
+SRC_DIR="src"
+HOST_DIR="host"
+BUILD_DIR="build"
+CC="${CC:-cc}"
+
+mkdir -p $BUILD_DIR/host
+
+command -v avr-gcc >/dev/null 2>&1 || { echo "❌ avr-gcc not found. Install with: brew install avr-gcc"; exit 1; }
+command -v avr-nm >/dev/null 2>&1 || { echo "❌ avr-nm not found. Install with: brew install avr-gcc"; exit 1; }
+command -v simavr >/dev/null 2>&1 || { echo "❌ simavr not found. Install with: brew install simavr"; exit 1; }
+
+C_FILES=$(find $SRC_DIR -name "*.c" -type f)
+
+echo "🔧 Compiling firmware..."
+
+# Same flags as flash.sh, so that the cycles match what gets flashed
+avr-gcc -mmcu=$MCU -Wall -O3 -DF_CPU=$F_CPU -I$SRC_DIR -o $BUILD_DIR/$TARGET.elf $C_FILES
+avr-nm -n --defined-only $BUILD_DIR/$TARGET.elf > $BUILD_DIR/$TARGET.sym
+
+echo "🔧 Compiling profiler..."
+
+if pkg-config --exists simavr 2>/dev/null; then
+    SIMAVR_FLAGS=$(pkg-config --cflags --libs simavr)
+else
+    SIMAVR_FLAGS="-lsimavr -lelf"
+fi
+
+$CC -std=gnu11 -Wall -O2 -I$SRC_DIR -o $BUILD_DIR/host/profile $HOST_DIR/profile.c $SIMAVR_FLAGS
+
+echo "⏱️  Profiling..."
+
+./$BUILD_DIR/host/profile $BUILD_DIR/$TARGET.elf $BUILD_DIR/$TARGET.sym "$@"
@@ -29,34 +29,99 @@ BIT_NO(MUX0, 0);
 
 #define ADCSRA EXPAND_ADDRESS(0x7A)
 BIT_NO(ADEN, 7);
+BIT_NO(ADATE, 5);
 BIT_NO(ADIE, 3);
 BIT_NO(ADPS0, 0);
 #define PRESCALER 0b111
 
+#define ADCSRB EXPAND_ADDRESS(0x7B)
+BIT_NO(ADTS0, 0);
+// Auto trigger source: Timer/Counter1 compare match B
+#define TRIGGER_SOURCE 0b101
+
+// Timer1 is only used to pace the conversions
+// https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-7810-Automotive-Microcontrollers-ATmega328P_Datasheet.pdf#page=108
+#define TCCR1A EXPAND_ADDRESS(0x80)
+#define TCCR1B EXPAND_ADDRESS(0x81)
+BIT_NO(WGM12, 3);
+BIT_NO(CS10, 0);
+#define OCR1AL EXPAND_ADDRESS(0x88)
+#define OCR1AH EXPAND_ADDRESS(0x89)
+#define OCR1BL EXPAND_ADDRESS(0x8A)
+#define OCR1BH EXPAND_ADDRESS(0x8B)
+#define TIFR1  EXPAND_ADDRESS(0x36)
+BIT(OCF1B, 2);
+
+// (64 * 250) / 16000000 = 1 ms between conversions: CTC mode, clock / 64, TOP = 249
+#define TRIGGER_PRESCALER_BITS 0b011
+#define TRIGGER_TOP            (F_CPU / 64 / 1000 - 1)
+
 // REFS0..1
 // Currently AVcc (5v)
 #define REFERENCE 0b01
 
-volatile boolean conversion_requested;
-volatile boolean conversion_started;
-volatile boolean conversion_complete;
-volatile uint16_t result;
+// Oversampling: OVERSAMPLE conversions are summed into one reading, 2 more bits of scale. Each
+// extra effective bit takes 4 times the samples (and at least 1 LSB of noise), so 4 of them only
+// gain 1 bit of resolution: the point is mostly averaging out the noise of the potentiometer
+#define OVERSAMPLE_BITS 2
+#define OVERSAMPLE      (1 << OVERSAMPLE_BITS)
+// Filtered readings keep 4 fractional bits (Q10.4)
+#define FILTER_FRACTION_BITS 4
+// IIR low pass: each reading moves the filtered value by 1/4 of the difference, rounded to nearest
+#define IIR_SHIFT 2
+
+// Timer1 starts a conversion every ms, split round robin between the sampled channels: a filtered
+// reading every OVERSAMPLE ms per channel (times the number of channels), for ~1000 interrupts per
+// second instead of the ~9600 of back to back conversions. The main loop only ever reads the
+// latest filtered value.
+
+uint8_t          channels[ANALOG_MAX_CHANNELS];
+volatile uint8_t channels_len = 0;
+uint8_t          channel_idx  = 0;
+
+// Oversampling accumulator of the current channel
+uint16_t sum     = 0;
+uint8_t  samples = 0;
+
+// Per pin, Q10.4, valid once the pin bit is set in `primed`
+volatile uint16_t filtered[ANALOG_PINS];
+volatile uint8_t  primed = 0;
+
+void select_channel(uint8_t pin_no) {
+    // Clear MUX0..3, then set MUX0..2 to the correct pin (channel).
+    // We are discarding MUX3 as it's reserved bits + fixed voltages
+    ADMUX = (ADMUX & 0xF0) | ((pin_no & 0b111) << MUX0);
+}
 
 // ADC conversion complete
 INTERRUPT(21) {
-    result = ADCL;
-    conversion_complete = true;
-
-    // This check is only needed to detect inconsistencies; removing it poses no
-    // harm
-    if (!conversion_started) {
-        throw_error(CONVERSION_NOT_STARTED);
+    sum += ADCL;
+    samples++;
+
+    if (samples == OVERSAMPLE) {
+        uint8_t  pin   = channels[channel_idx];
+        uint16_t value = sum << (FILTER_FRACTION_BITS - OVERSAMPLE_BITS);
+
+        if (primed & (1 << pin)) {
+            // The shift rounds toward minus infinity, the half LSB makes it round to nearest
+            filtered[pin] +=
+                ((int16_t) (value - filtered[pin]) + (1 << (IIR_SHIFT - 1))) >> IIR_SHIFT;
+        } else {
+            filtered[pin] = value;
+            primed |= 1 << pin;
+        }
+
+        sum     = 0;
+        samples = 0;
+
+        // The multiplexer is latched when a conversion starts, switching here is safe: the next
+        // trigger is a ms away
+        channel_idx = channel_idx + 1 >= channels_len ? 0 : channel_idx + 1;
+        select_channel(channels[channel_idx]);
     }
-    conversion_started = false;
 
-    // Disable ADC
-    // This is needed because I found no other solution for single conversions
-    CLEAR_BIT(ADCSRA, ADEN);
+    // The trigger is the rising edge of the flag, which has no interrupt of its own to clear it
+    TIFR1 = OCF1B;
 }
 
 void init_ADC() {
@@ -68,45 +133,56 @@ void init_ADC() {
 
     // Enable interrupts
     SET_BIT(ADCSRA, ADIE);
-}
 
-// Pins A0..5 in the Arduino Uno
-void analog_read_pin_start(uint8_t pin_no) {
-    conversion_requested = true;
-
-    // Clear MUX0..3
-    ADMUX &= 0xF0;
+    // Conversions start on Timer1 compare match B
+    ADCSRB = (ADCSRB & ~(0b111 << ADTS0)) | (TRIGGER_SOURCE << ADTS0);
+    SET_BIT(ADCSRA, ADATE);
 
-    // Better safe than sorry
-    // We are discarding MUX3 as it's reserved bits + fixed voltages
-    pin_no &= 0b111;
+    // Enabled once: only the very first conversion pays the 25 cycles initialization
+    SET_BIT(ADCSRA, ADEN);
 
-    // Sets MUX0..2 to the correct pin (channel)
-    ADMUX |= pin_no << MUX0;
+    // CTC mode (TOP = OCR1A), match B at TOP too. High bytes first: they go through a shared
+    // temporary register. Stopped until the first channel is sampled
+    TCCR1A = 0;
+    TCCR1B = 1 << WGM12;
+    OCR1AH = TRIGGER_TOP >> 8;
+    OCR1AL = TRIGGER_TOP & 0xFF;
+    OCR1BH = TRIGGER_TOP >> 8;
+    OCR1BL = TRIGGER_TOP & 0xFF;
+}
 
-    conversion_complete = false;
-    conversion_started = true;
+// Pins A0..5 in the Arduino Uno
+void analog_sample_pin(uint8_t pin_no) {
+    for (uint8_t i = 0; i < channels_len; i++) {
+        if (channels[i] == pin_no) {
+            return;
+        }
+    }
+    if (channels_len == ANALOG_MAX_CHANNELS) {
+        return;
+    }
 
-    // Enable ADC
-    SET_BIT(ADCSRA, ADEN);
-}
+    // Published by the length, the ISR never reads past it
+    channels[channels_len] = pin_no;
+    channels_len++;
 
-// `analog_read_pin_start` must be called before this
-uint16_t analog_read_pin_join() {
-    if (!conversion_requested) {
-        throw_error(CONVERSION_NOT_REQUESTED);
+    if (channels_len == 1) {
+        channel_idx = 0;
+        select_channel(pin_no);
+        // Start the trigger
+        TCCR1B |= TRIGGER_PRESCALER_BITS << CS10;
     }
-    conversion_requested = false;
 
-    // Wait for conversion
-    while (!conversion_complete) {
+    while (!(primed & (1 << pin_no))) {
         sleep();
     }
-
-    return result;
 }
 
-uint16_t analog_read_pin_sync(uint8_t pin_no) {
-    analog_read_pin_start(pin_no);
-    return analog_read_pin_join();
+uint16_t analog_latest(uint8_t pin_no) {
+    uint16_t value;
+    CRITICAL {
+        value = filtered[pin_no];
+    }
+    // Rounded
+    return (value + (1 << (FILTER_FRACTION_BITS - 1))) >> FILTER_FRACTION_BITS;
 }
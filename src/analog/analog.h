@@ -3,12 +3,16 @@
 
 #include "../utils/utils.h"
 
-// Separate start and join so that immediately waiting for the ADC is optional
+// Pins sampled in the background, round robin, oversampled and low pass filtered
 
-void analog_read_pin_start(uint8_t pin_no);
-uint16_t analog_read_pin_join();
+#define ANALOG_PINS         6
+#define ANALOG_MAX_CHANNELS ANALOG_PINS
 
-uint16_t analog_read_pin_sync(uint8_t pin_no);
 void init_ADC();
 
+// Adds `pin_no` to the sampled pins. Waits for its first reading, requires interrupts
+void analog_sample_pin(uint8_t pin_no);
+// Latest filtered reading of a sampled pin, 10 bits. Never waits
+uint16_t analog_latest(uint8_t pin_no);
+
 #endif
@@ -0,0 +1,312 @@
+#include "frame.h"
+#include "../serial/serial.h"
+#include "frame_tables.h"
+
+#if FRAME_TABLES_SCREENX != SCREENX || FRAME_TABLES_BITS_PER_COLOR != BITS_PER_COLOR
+    #error "frame_tables.h is out of date, run generate-types.sh"
+#endif
+
+// Colors store example:
+//   x0  x1  x2  x3  x4  x5  x6  x7
+//
+//   1   2   3   4   1   2   3   4   y0
+//   5   6   7   8   5   6   7   8   y1
+//   9  10  11  12   9  10  11  12   y2
+//
+// 1.2.3.4     1.2.3.4
+// 5.6.7.8     5.6.7.8
+// 9.10.11.12  9.10.11.12
+//
+// A cell is one of these bytes: COLORS_PER_BYTE pixels of the same row.
+//
+// Two kinds of frame are sent:
+// - Keyframe: FRAME_START, then every cell of the screen row by row (SCREENY * FRAME_COLS bytes),
+//   then FRAME_END. With FRAME_MODE_RLE, runs of empty cells are sent as RLE_RUN + count instead
+// - Delta: DELTA_FRAME_START, then (col, row, value) for each cell that changed since the previous
+//   frame, then FRAME_END. Almost the whole screen is background, so this is a few dozen bytes
+//   instead of 1200. Keyframes are still sent periodically so that the frontend can resync.
+//   Only with FRAME_MODE_DELTA, otherwise every frame is a keyframe.
+//
+// With FRAME_MODE_CHECK, FRAME_END is preceded by FRAME_CHECK + the CRC-8 of every data byte of the
+// frame, so that the frontend can tell a corrupted frame from a complete one. Unlike a XOR, it also
+// catches two flips of the same bit and swapped bytes. Data bytes only carry 7 bits, so the CRC is
+// sent as its high bit then its low 7 bits.
+//
+// The frontend picks the mode with SET_FRAME_MODE. Until then every frame is a plain keyframe, the
+// only format older frontends understand.
+//
+// The USART drains a frame from its cells while the next tick is computed: frame_send() only waits
+// if the previous frame is still in flight, and counts it as an overrun.
+
+#define FRAME_CELLS (SCREENY * FRAME_COLS)
+// A delta sends col and row as plain data bytes, bit 7 would turn them into commands
+#if SCREENY > 128 || FRAME_COLS > 128
+    #error "Delta frames need SCREENY and FRAME_COLS to fit in 7 bits"
+#endif
+// Shorter runs are cheaper as plain bytes
+#define MIN_RUN_LENGTH 3
+// A count must fit in a data byte
+#define MAX_RUN_LENGTH 127
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    uint8_t value;
+} cell_t;
+
+// Non-empty cells of the frame being sent and of the previous one, sorted by (row, col)
+cell_t  cells[2][FRAME_MAX_PIXELS];
+uint8_t cells_len[2];
+uint8_t current_cells = 0;
+
+uint8_t frames_since_keyframe = KEYFRAME_INTERVAL;
+
+// Frames handed to the USART and the last one fully sent, they differ while a frame is in flight
+uint8_t          frame_sequence      = 0;
+volatile uint8_t frame_sent_sequence = 0;
+uint16_t         frame_overruns      = 0;
+
+// Requested by the frontend, applied from the next frame
+volatile uint8_t requested_frame_mode = 0;
+uint8_t          frame_mode           = 0;
+
+typedef enum __attribute__((packed)) {
+    SEND_START,
+    SEND_KEYFRAME,
+    SEND_RUN_LENGTH,
+    SEND_DELTA,
+    SEND_CHECK_COMMAND,
+    SEND_END,
+    SEND_CHECK,
+    SEND_CHECK_LOW,
+    SEND_DONE,
+} frame_send_status_t;
+
+// Tracks the state of sending a frame
+volatile frame_send_status_t frame_send_status = SEND_DONE;
+boolean                      keyframe;
+// Keyframe: position of the next byte (row * FRAME_COLS + col), and the next non-empty cell
+uint16_t send_pos;
+uint8_t  send_cell_idx;
+uint8_t  run_length;
+// CRC-8 of the data bytes sent so far
+uint8_t frame_check;
+// Delta: merge cursors over the previous and current cells, and the change being sent
+uint8_t previous_cell_idx;
+uint8_t current_cell_idx;
+cell_t  change;
+uint8_t change_byte_idx;
+
+// Merge of the two sorted cell lists, returns the next cell whose value differs
+boolean next_change() {
+    cell_t *previous     = cells[current_cells ^ 1];
+    cell_t *current      = cells[current_cells];
+    uint8_t previous_len = cells_len[current_cells ^ 1];
+    uint8_t current_len  = cells_len[current_cells];
+
+    while (previous_cell_idx < previous_len || current_cell_idx < current_len) {
+        int8_t order;
+        if (previous_cell_idx == previous_len) {
+            order = 1;
+        } else if (current_cell_idx == current_len) {
+            order = -1;
+        } else {
+            cell_t *p = &previous[previous_cell_idx];
+            cell_t *c = &current[current_cell_idx];
+            order     = p->row != c->row ? (p->row < c->row ? -1 : 1)
+                      : p->col != c->col ? (p->col < c->col ? -1 : 1)
+                                         : 0;
+        }
+
+        if (order < 0) {
+            // Only in the previous frame: cleared
+            change       = previous[previous_cell_idx++];
+            change.value = 0;
+            return true;
+        }
+        if (order > 0) {
+            // Only in the current frame: new
+            change = current[current_cell_idx++];
+            return true;
+        }
+
+        change = current[current_cell_idx++];
+        if (previous[previous_cell_idx++].value != change.value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+volatile boolean frame_generator_f(uint8_t *data) {
+    switch (frame_send_status) {
+        case SEND_START:
+            frame_check = 0;
+            if (keyframe) {
+                *data             = SET_COMMAND(FRAME_START);
+                frame_send_status = SEND_KEYFRAME;
+                send_pos          = 0;
+                send_cell_idx     = 0;
+            } else {
+                *data             = SET_COMMAND(DELTA_FRAME_START);
+                frame_send_status = SEND_DELTA;
+                previous_cell_idx = 0;
+                current_cell_idx  = 0;
+                change_byte_idx   = 0;
+            }
+            return true;
+
+        case SEND_KEYFRAME: {
+            // Position of the next non-empty cell, or the end of the frame
+            uint16_t next_cell_pos = FRAME_CELLS;
+            cell_t  *cell          = &cells[current_cells][send_cell_idx];
+            if (send_cell_idx < cells_len[current_cells]) {
+                next_cell_pos = cell->row * FRAME_COLS + cell->col;
+            }
+
+            uint16_t empty_cells = next_cell_pos - send_pos;
+            if ((frame_mode & FRAME_MODE_RLE) && empty_cells >= MIN_RUN_LENGTH) {
+                *data             = SET_COMMAND(RLE_RUN);
+                run_length        = empty_cells > MAX_RUN_LENGTH ? MAX_RUN_LENGTH : empty_cells;
+                frame_send_status = SEND_RUN_LENGTH;
+                return true;
+            }
+
+            if (empty_cells == 0) {
+                *data = cell->value;
+                send_cell_idx++;
+            } else {
+                *data = 0;
+            }
+            frame_check = progmem_read_byte(&frame_crc_table[frame_check ^ *data]);
+
+            // Advance to the next byte position in the frame
+            send_pos++;
+            if (send_pos == FRAME_CELLS) {
+                frame_send_status = SEND_CHECK_COMMAND;
+            }
+            return true;
+        }
+
+        case SEND_RUN_LENGTH:
+            *data       = run_length;
+            frame_check = progmem_read_byte(&frame_crc_table[frame_check ^ run_length]);
+            send_pos += run_length;
+            frame_send_status = send_pos == FRAME_CELLS ? SEND_CHECK_COMMAND : SEND_KEYFRAME;
+            return true;
+
+        case SEND_DELTA:
+            if (change_byte_idx != 0 || next_change()) {
+                switch (change_byte_idx) {
+                    case 0:
+                        *data = change.col;
+                        break;
+                    case 1:
+                        *data = change.row;
+                        break;
+                    default:
+                        *data = change.value;
+                        break;
+                }
+                frame_check     = progmem_read_byte(&frame_crc_table[frame_check ^ *data]);
+                change_byte_idx = change_byte_idx == 2 ? 0 : change_byte_idx + 1;
+                return true;
+            }
+            frame_send_status = SEND_CHECK_COMMAND;
+            // Fall through, no changes left
+
+        case SEND_CHECK_COMMAND:
+            if (frame_mode & FRAME_MODE_CHECK) {
+                *data             = SET_COMMAND(FRAME_CHECK);
+                frame_send_status = SEND_CHECK;
+                return true;
+            }
+            // Fall through, no check requested
+
+        case SEND_END:
+            *data               = SET_COMMAND(FRAME_END);
+            frame_send_status   = SEND_DONE;
+            frame_sent_sequence = frame_sequence;
+            return true;
+
+        case SEND_CHECK:
+            *data             = frame_check >> 7;
+            frame_send_status = SEND_CHECK_LOW;
+            return true;
+
+        case SEND_CHECK_LOW:
+            *data             = frame_check & 0x7F;
+            frame_send_status = SEND_END;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Packs the sorted pixels into cells
+void build_cells(colored_pixels_t *pixels, uint8_t len) {
+    cell_t *cell_list = cells[current_cells];
+    uint8_t cell_len  = 0;
+
+    if (len > FRAME_MAX_PIXELS) {
+        len = FRAME_MAX_PIXELS;
+    }
+
+    for (uint8_t i = 0; i < len; i++) {
+        // x_pos < SCREENX: the caller only keeps the pixels on screen
+        uint8_t x_pos = pixels[i].x_pos;
+        uint8_t col   = progmem_read_byte(&frame_col_table[x_pos]);
+        // The color shifted into its bit position(s) within the byte
+        uint8_t value =
+            progmem_read_byte(&frame_value_table[progmem_read_byte(&frame_slot_table[x_pos]) +
+                                                 pixels[i].color]);
+
+        // Pixels are sorted: same cell as the previous pixel or a new one
+        if (cell_len > 0 && cell_list[cell_len - 1].row == pixels[i].y_pos &&
+            cell_list[cell_len - 1].col == col) {
+            cell_list[cell_len - 1].value |= value;
+        } else {
+            cell_list[cell_len++] = (cell_t) {.row = pixels[i].y_pos, .col = col, .value = value};
+        }
+    }
+
+    cells_len[current_cells] = cell_len;
+}
+
+void frame_set_mode(uint8_t mode) {
+    requested_frame_mode = mode;
+}
+
+void frame_join() {
+    if (frame_sent_sequence != frame_sequence) {
+        // The next frame was ready before the previous one left: transmit bound
+        frame_overruns++;
+    }
+    serial_out_join();
+}
+
+void frame_send(colored_pixels_t *pixels, uint8_t len) {
+    // The cells of the frame in flight must not change under the ISR
+    frame_join();
+
+    // The last sent frame becomes the delta base
+    current_cells ^= 1;
+    build_cells(pixels, len);
+
+    // Start the new mode with a keyframe, the frontend might have just connected
+    if (frame_mode != requested_frame_mode) {
+        frame_mode            = requested_frame_mode;
+        frames_since_keyframe = KEYFRAME_INTERVAL;
+    }
+
+    keyframe = !(frame_mode & FRAME_MODE_DELTA) || frames_since_keyframe >= KEYFRAME_INTERVAL;
+    if (keyframe) {
+        frames_since_keyframe = 0;
+    }
+    frames_since_keyframe++;
+
+    frame_sequence++;
+    frame_send_status = SEND_START;
+    send_data_generator_f(frame_generator_f);
+}
@@ -0,0 +1,39 @@
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "../generated.h"
+#include "../utils/utils.h"
+#include <stdint.h>
+
+// Reserve one bit for command/data mode
+#define COLORS_PER_BYTE ((8 - 1) / BITS_PER_COLOR)
+#define FRAME_COLS      (SCREENX / COLORS_PER_BYTE)
+
+// Most pixels a frame can hold
+#define FRAME_MAX_PIXELS 72
+
+// A full frame is sent every KEYFRAME_INTERVAL frames, only changes in between
+#define KEYFRAME_INTERVAL 60
+
+typedef struct {
+    uint8_t color;
+    uint8_t x_pos;
+    uint8_t y_pos;
+} colored_pixels_t;
+
+// Incremented for every frame handed to the USART, wraps around
+extern uint8_t frame_sequence;
+// Frames that were ready while the previous one was still being sent
+extern uint16_t frame_overruns;
+
+// FRAME_MODE_* flags, applied from the next frame
+void frame_set_mode(uint8_t mode);
+
+// Waits until the frame in flight has been sent. Counts an overrun if it had to wait
+void frame_join();
+
+// `pixels` must be sorted by y_pos, then x_pos. They are copied, the buffer can be reused
+// immediately. Returns as soon as the previous frame has been sent, without waiting for this one
+void frame_send(colored_pixels_t *pixels, uint8_t len);
+
+#endif
@@ -0,0 +1,21 @@
+#include "aim.h"
+
+#ifdef FLOAT_PHYSICS
+
+aim_t aim_from_adc(uint16_t adc) {
+    float angle_rad = ((float) adc) / ((1 << ADC_BITS) - 1) * M_PI;
+    return (aim_t) {.x = cosf(angle_rad), .y = sinf(angle_rad)};
+}
+
+#else
+
+    #include "aim_table.h"
+
+// Table lookup instead of a float divide, cosf and sinf
+aim_t aim_from_adc(uint16_t adc) {
+    uint8_t index = adc >> (ADC_BITS - AIM_TABLE_BITS);
+    return (aim_t) {.x = progmem_read_word(&aim_cos_table[index]),
+                    .y = progmem_read_word(&aim_sin_table[index])};
+}
+
+#endif
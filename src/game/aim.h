@@ -0,0 +1,18 @@
+#ifndef _AIM_H
+#define _AIM_H
+
+#include "physics.h"
+#include <stdint.h>
+
+#define ADC_BITS 10
+
+// Unit vector of the cannon direction. y is positive upwards
+typedef struct {
+    scalar_t x;
+    scalar_t y;
+} aim_t;
+
+// `adc` is the raw 10 bit potentiometer reading: 0 aims right, max aims left
+aim_t aim_from_adc(uint16_t adc);
+
+#endif
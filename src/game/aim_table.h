@@ -0,0 +1,64 @@
+// THIS FILE IS AUTOGENERATED FROM generate-types.sh
+// DO NOT MODIFY MANUALLY
+
+#ifndef AIM_TABLE_H
+#define AIM_TABLE_H
+
+#include "../utils/utils.h"
+#include "fixed.h"
+
+#define AIM_TABLE_BITS 8
+#define AIM_TABLE_LEN (1 << AIM_TABLE_BITS)
+
+// Q8.8 cos/sin of i * PI / (AIM_TABLE_LEN - 1)
+static const fixed_t aim_cos_table[AIM_TABLE_LEN] PROGMEM = {
+    256, 256, 256, 256, 256, 256, 255, 255, 255, 254, 254, 254,
+    253, 253, 252, 252, 251, 250, 250, 249, 248, 247, 247, 246,
+    245, 244, 243, 242, 241, 240, 239, 238, 236, 235, 234, 233,
+    231, 230, 228, 227, 226, 224, 222, 221, 219, 218, 216, 214,
+    213, 211, 209, 207, 205, 203, 201, 199, 197, 195, 193, 191,
+    189, 187, 185, 183, 180, 178, 176, 174, 171, 169, 167, 164,
+    162, 159, 157, 154, 152, 149, 147, 144, 141, 139, 136, 133,
+    131, 128, 125, 122, 120, 117, 114, 111, 108, 106, 103, 100,
+    97, 94, 91, 88, 85, 82, 79, 76, 73, 70, 67, 64,
+    61, 58, 55, 52, 49, 45, 42, 39, 36, 33, 30, 27,
+    24, 20, 17, 14, 11, 8, 5, 2, -2, -5, -8, -11,
+    -14, -17, -20, -24, -27, -30, -33, -36, -39, -42, -45, -49,
+    -52, -55, -58, -61, -64, -67, -70, -73, -76, -79, -82, -85,
+    -88, -91, -94, -97, -100, -103, -106, -108, -111, -114, -117, -120,
+    -122, -125, -128, -131, -133, -136, -139, -141, -144, -147, -149, -152,
+    -154, -157, -159, -162, -164, -167, -169, -171, -174, -176, -178, -180,
+    -183, -185, -187, -189, -191, -193, -195, -197, -199, -201, -203, -205,
+    -207, -209, -211, -213, -214, -216, -218, -219, -221, -222, -224, -226,
+    -227, -228, -230, -231, -233, -234, -235, -236, -238, -239, -240, -241,
+    -242, -243, -244, -245, -246, -247, -247, -248, -249, -250, -250, -251,
+    -252, -252, -253, -253, -254, -254, -254, -255, -255, -255, -256, -256,
+    -256, -256, -256, -256,
+};
+
+static const fixed_t aim_sin_table[AIM_TABLE_LEN] PROGMEM = {
+    0, 3, 6, 9, 13, 16, 19, 22, 25, 28, 31, 35,
+    38, 41, 44, 47, 50, 53, 56, 59, 62, 65, 69, 72,
+    75, 78, 81, 84, 87, 90, 92, 95, 98, 101, 104, 107,
+    110, 113, 116, 118, 121, 124, 127, 129, 132, 135, 137, 140,
+    143, 145, 148, 150, 153, 156, 158, 160, 163, 165, 168, 170,
+    172, 175, 177, 179, 182, 184, 186, 188, 190, 192, 194, 196,
+    198, 200, 202, 204, 206, 208, 210, 212, 213, 215, 217, 218,
+    220, 222, 223, 225, 226, 228, 229, 231, 232, 233, 235, 236,
+    237, 238, 239, 240, 241, 242, 243, 244, 245, 246, 247, 248,
+    249, 249, 250, 251, 251, 252, 252, 253, 253, 254, 254, 255,
+    255, 255, 255, 256, 256, 256, 256, 256, 256, 256, 256, 256,
+    256, 255, 255, 255, 255, 254, 254, 253, 253, 252, 252, 251,
+    251, 250, 249, 249, 248, 247, 246, 245, 244, 243, 242, 241,
+    240, 239, 238, 237, 236, 235, 233, 232, 231, 229, 228, 226,
+    225, 223, 222, 220, 218, 217, 215, 213, 212, 210, 208, 206,
+    204, 202, 200, 198, 196, 194, 192, 190, 188, 186, 184, 182,
+    179, 177, 175, 172, 170, 168, 165, 163, 160, 158, 156, 153,
+    150, 148, 145, 143, 140, 137, 135, 132, 129, 127, 124, 121,
+    118, 116, 113, 110, 107, 104, 101, 98, 95, 92, 90, 87,
+    84, 81, 78, 75, 72, 69, 65, 62, 59, 56, 53, 50,
+    47, 44, 41, 38, 35, 31, 28, 25, 22, 19, 16, 13,
+    9, 6, 3, 0,
+};
+
+#endif
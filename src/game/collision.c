@@ -0,0 +1,55 @@
+#include "collision.h"
+
+// Columns per cell. Must be >= HIT_DISTANCE, so that a query touches at most 3 cells
+#define CELL_BITS 2
+#define CELLS     ((SCREENX >> CELL_BITS) + 1)
+
+// Projectile indexes sorted by cell: cell `c` owns [cell_start[c], cell_start[c + 1])
+uint8_t sorted_projectiles[MAX_PROJECTILES];
+uint8_t cell_start[CELLS + 1];
+
+// Projectiles are always on screen, but a bad position must not write out of bounds
+uint8_t cell_of(scalar_t x) {
+    uint8_t cell = SCALAR_TO_PIXEL(x) >> CELL_BITS;
+    return cell < CELLS ? cell : CELLS - 1;
+}
+
+void collision_build() {
+    for (uint8_t i = 0; i <= CELLS; i++) {
+        cell_start[i] = 0;
+    }
+
+    // Counted one slot ahead, so that the prefix sum directly gives the start offsets
+    for (uint8_t i = 0; i < projectiles.len; i++) {
+        cell_start[cell_of(projectiles.pos_x[i]) + 1]++;
+    }
+    for (uint8_t i = 1; i <= CELLS; i++) {
+        cell_start[i] += cell_start[i - 1];
+    }
+
+    // Use the start offsets as insertion cursors: afterwards cell_start[c] is the end of cell c,
+    // i.e. cell c spans [cell_start[c - 1], cell_start[c])
+    for (uint8_t i = 0; i < projectiles.len; i++) {
+        sorted_projectiles[cell_start[cell_of(projectiles.pos_x[i])]++] = i;
+    }
+}
+
+boolean collision_hit(scalar_t x, scalar_t y) {
+    uint8_t pixel_x    = SCALAR_TO_PIXEL(x);
+    uint8_t first_cell = pixel_x < HIT_DISTANCE ? 0 : (pixel_x - HIT_DISTANCE) >> CELL_BITS;
+    uint8_t last_cell  = cell_of(x + SCALAR_INT(HIT_DISTANCE));
+
+    uint8_t from = first_cell == 0 ? 0 : cell_start[first_cell - 1];
+    uint8_t to   = cell_start[last_cell];
+
+    for (uint8_t i = from; i < to; i++) {
+        uint8_t  projectile = sorted_projectiles[i];
+        scalar_t dx         = SCALAR_ABS(x - projectiles.pos_x[projectile]);
+        scalar_t dy         = SCALAR_ABS(y - projectiles.pos_y[projectile]);
+
+        if (dx + dy <= SCALAR_INT(HIT_DISTANCE)) {
+            return true;
+        }
+    }
+    return false;
+}
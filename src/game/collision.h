@@ -0,0 +1,21 @@
+#ifndef _COLLISION_H
+#define _COLLISION_H
+
+// Broad phase for parachute vs projectile hits.
+//
+// Projectiles are bucketed by column with a counting sort, rebuilt once per tick, so that each
+// parachute only tests the projectiles in the few columns within reach instead of all of them.
+
+#include "../utils/utils.h"
+#include "entities.h"
+#include "physics.h"
+
+// Manhattan distance (px) under which a projectile hits a parachute
+#define HIT_DISTANCE 2
+
+// Indexes the projectile store. Projectiles must not be moved or deleted until the last query
+void collision_build();
+
+boolean collision_hit(scalar_t x, scalar_t y);
+
+#endif
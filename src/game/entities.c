@@ -0,0 +1,42 @@
+#include "entities.h"
+
+cannon_t      cannon;
+projectiles_t projectiles;
+parachutes_t  parachutes;
+
+void init_entities() {
+    projectiles.len = 0;
+    parachutes.len  = 0;
+}
+
+uint8_t spawn_projectile() {
+    if (projectiles.len >= MAX_PROJECTILES) {
+        throw_error(GAME_MAX_ENTITIES_REACHED);
+    }
+    projectiles.carry_x[projectiles.len] = 0;
+    projectiles.carry_y[projectiles.len] = 0;
+    return projectiles.len++;
+}
+
+uint8_t spawn_parachute() {
+    if (parachutes.len >= MAX_PARACHUTES) {
+        throw_error(GAME_MAX_ENTITIES_REACHED);
+    }
+    return parachutes.len++;
+}
+
+void delete_projectile(uint8_t index) {
+    uint8_t last               = --projectiles.len;
+    projectiles.pos_x[index]   = projectiles.pos_x[last];
+    projectiles.pos_y[index]   = projectiles.pos_y[last];
+    projectiles.speed_x[index] = projectiles.speed_x[last];
+    projectiles.speed_y[index] = projectiles.speed_y[last];
+    projectiles.carry_x[index] = projectiles.carry_x[last];
+    projectiles.carry_y[index] = projectiles.carry_y[last];
+}
+
+void delete_parachute(uint8_t index) {
+    uint8_t last            = --parachutes.len;
+    parachutes.pos_x[index] = parachutes.pos_x[last];
+    parachutes.pos_y[index] = parachutes.pos_y[last];
+}
@@ -0,0 +1,64 @@
+#ifndef _ENTITIES_H
+#define _ENTITIES_H
+
+// Entity store: every variant lives in its own packed arrays (structure of arrays), so the hot
+// loops walk a single variant without branching on it, and each cap can be tuned on its own.
+
+#include "../generated.h"
+#include "../utils/utils.h"
+#include "physics.h"
+#include <stdint.h>
+
+#define CANNON_ENTITIES (SCREENY / 10)
+#define MAX_PROJECTILES 48
+// One spawns per second and they take ~10 seconds to land
+#define MAX_PARACHUTES 16
+
+#define MAX_ENTITIES_LEN (CANNON_ENTITIES + MAX_PROJECTILES + MAX_PARACHUTES)
+
+// Values are the colors
+typedef enum __attribute((__packed__)) {
+    PROJ           = 1,
+    PARACHUTE      = 2,
+    CANNON_POINTER = 3,
+} entity_variant_t;
+
+// Positions only, recomputed from the aim every tick
+typedef struct {
+    scalar_t pos_x[CANNON_ENTITIES];
+    scalar_t pos_y[CANNON_ENTITIES];
+} cannon_t;
+
+typedef struct {
+    scalar_t pos_x[MAX_PROJECTILES];
+    scalar_t pos_y[MAX_PROJECTILES];
+    scalar_t speed_x[MAX_PROJECTILES];
+    scalar_t speed_y[MAX_PROJECTILES];
+    // What the positions could not hold of the moves so far, see SCALAR_TAKE_FINE
+    uint8_t carry_x[MAX_PROJECTILES];
+    uint8_t carry_y[MAX_PROJECTILES];
+    uint8_t len;
+} projectiles_t;
+
+// Parachutes all fall straight down at the same speed, no need to store it
+typedef struct {
+    scalar_t pos_x[MAX_PARACHUTES];
+    scalar_t pos_y[MAX_PARACHUTES];
+    uint8_t  len;
+} parachutes_t;
+
+extern cannon_t      cannon;
+extern projectiles_t projectiles;
+extern parachutes_t  parachutes;
+
+void init_entities();
+
+// Return the index of the new (uninitialized) entity
+uint8_t spawn_projectile();
+uint8_t spawn_parachute();
+
+// Swap-remove: the last entity of the same variant takes `index`
+void delete_projectile(uint8_t index);
+void delete_parachute(uint8_t index);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef _FIXED_H
+#define _FIXED_H
+
+#include <stdint.h>
+
+// The AVR has no FPU: every float operation is a libgcc call worth ~100 cycles. Fixed point only
+// needs the hardware 8x8 multiplier and shifts.
+
+// Signed Q8.8: 8 integer bits (covers the whole screen) and 1/256 px of precision
+typedef int16_t fixed_t;
+
+#define FIXED_FRACTION_BITS 8
+#define FIXED_ONE           (1 << FIXED_FRACTION_BITS)
+
+// Meant for constants, the float math is folded at compile time
+#define FIXED_FROM_FLOAT(x) ((fixed_t) ((x) * FIXED_ONE + ((x) >= 0 ? 0.5f : -0.5f)))
+#define FIXED_FROM_INT(x)   ((fixed_t) ((x) * FIXED_ONE))
+// Floor, same as the float -> int cast for positive values
+#define FIXED_TO_INT(x) ((x) >> FIXED_FRACTION_BITS)
+
+// Unsigned Q0.16 seconds, used for tick deltas (always below one second)
+typedef uint16_t fixed_dt_t;
+
+__attribute__((always_inline)) inline fixed_t fixed_mul(fixed_t a, fixed_t b) {
+    return ((int32_t) a * b) >> FIXED_FRACTION_BITS;
+}
+
+// Rounded, otherwise small speeds would always be truncated towards -inf
+__attribute__((always_inline)) inline fixed_t fixed_mul_dt(fixed_t value, fixed_dt_t dt) {
+    return ((int32_t) value * dt + (1L << 15)) >> 16;
+}
+
+// One 32 bit division, do it once per tick and not per entity.
+// Saturates at (almost) one second
+__attribute__((always_inline)) inline fixed_dt_t fixed_dt_from_ms(uint32_t ms) {
+    if (ms >= 1000) {
+        return UINT16_MAX;
+    }
+    return (ms << 16) / 1000;
+}
+
+// Constant step of a fixed rate, folded at compile time
+#define FIXED_DT_FROM_HZ(hz) ((fixed_dt_t) ((65536UL + (hz) / 2) / (hz)))
+
+// Signed Q8.16, for the amounts added at every simulation step. At 240 Hz they are a fraction of a
+// Q8.8 unit: rounded to Q8.8, the parachute speed would be 6% off and the gravity 4% off
+typedef int32_t fixed_fine_t;
+
+#define FIXED_FINE_BITS 8
+#define FIXED_FINE_ONE  (1L << (FIXED_FRACTION_BITS + FIXED_FINE_BITS))
+
+#define FIXED_FINE_FROM_FLOAT(x) ((fixed_fine_t) ((x) * FIXED_FINE_ONE + ((x) >= 0 ? 0.5f : -0.5f)))
+
+// Not rounded, the fine bits are kept
+__attribute__((always_inline)) inline fixed_fine_t fixed_mul_dt_fine(fixed_t    value,
+                                                                     fixed_dt_t dt) {
+    return ((int32_t) value * dt) >> (16 - FIXED_FINE_BITS);
+}
+
+// Whole Q8.8 units of `fine`. The fine bits left over are kept in `carry` and added to the next
+// call with the same carry: over any number of calls, the sum is less than one unit away from the
+// exact one instead of drifting by up to half a unit per call
+__attribute__((always_inline)) inline fixed_t fixed_take_fine(fixed_fine_t fine, uint8_t *carry) {
+    fixed_fine_t total = fine + *carry;
+    // Floor, the carry is always positive
+    *carry = total & 0xFF;
+    return total >> FIXED_FINE_BITS;
+}
+
+__attribute__((always_inline)) inline fixed_t fixed_abs(fixed_t x) {
+    return x < 0 ? -x : x;
+}
+
+#endif
@@ -1,23 +1,13 @@
+#include "../frame/frame.h"
 #include "../generated.h"
 #include "../lcd2004/lcd2004.h"
-#include "../serial/serial.h"
+#include "collision.h"
+#include "entities.h"
+#include "game.h"
 #include "math.h"
+#include "physics.h"
 #include <stdint.h>
 
-// Reserve one bit for command/data mode
-#define COLORS_PER_BYTE ((8 - 1) / BITS_PER_COLOR)
-
-// Colors store example:
-//   x0  x1  x2  x3  x4  x5  x6  x7
-//
-//   1   2   3   4   1   2   3   4   y0
-//   5   6   7   8   5   6   7   8   y1
-//   9  10  11  12   9  10  11  12   y2
-//
-// 1.2.3.4     1.2.3.4
-// 5.6.7.8     5.6.7.8
-// 9.10.11.12  9.10.11.12
-
 // Float/int relationship in the canvas:
 //
 //                                   SCREENX
@@ -28,21 +18,6 @@
 // C cast in positive integers does a floor operation; 2.5 becomes 2 and paints the correct pixel
 
 
-// Values are the colors
-typedef enum __attribute((__packed__)) {
-    PROJ           = 1,
-    PARACHUTE      = 2,
-    CANNON_POINTER = 3,
-} entity_variant_t;
-
-typedef struct {
-    entity_variant_t variant;
-    float            pos_x;
-    float            pos_y;
-    float            speed_x;
-    float            speed_y;
-} entity_t;
-
 // Speeds are declared in display%/sec, converted to px/sec
 #define SPEED_UNIT         (SCREENX / 100.f)
 #define MAX_AMMO           50
@@ -52,303 +27,291 @@ typedef struct {
 #define PARACHUTE_SPEED    (-10.0f * SPEED_UNIT)
 #define G                  9.81f
 #define PARACHUTE_SPAWN_MS 1000
-#define CANNON_ENTITIES    (SCREENY / 10)
 
-#define MAX_ENTITIES_LEN 50
-entity_t entities[MAX_ENTITIES_LEN];
-uint8_t  entities_len       = 0;
-uint32_t last_tick          = 0;
-uint32_t last_shot_ms       = 0;
-uint32_t last_chute_spawned = 0;
-uint32_t bullets_time       = 0;
+// Every timer counts simulation steps, rounded
+#define STEPS_FROM_MS(ms)     (((ms) * SIM_HZ + 500) / 1000)
+#define RECHARGE_STEPS        STEPS_FROM_MS(RECHARGE_TIME_MS)
+#define REGEN_STEPS           STEPS_FROM_MS(REGEN_TIME_MS)
+#define PARACHUTE_SPAWN_STEPS STEPS_FROM_MS(PARACHUTE_SPAWN_MS)
+
+// Per step, folded at compile time. Gravity and the parachute fall are fractions of a Q8.8 unit per
+// step: they are kept as fine amounts and carried from one step to the next (SCALAR_TAKE_FINE), as
+// are the projectile moves. What is left against the float physics:
+// - SIM_DELTA is rounded to 1/65536 s, the projectiles move 0.02% slow
+// - the projectile speeds are truncated to 1/256 px/s when shot
+// - a position lags the exact sum of its moves by less than 1/256 px, a speed by 1/128 px/s
+#define SIM_DELTA      DELTA_FROM_HZ(SIM_HZ)
+#define GRAVITY_STEP   SCALAR_FINE(G / SIM_HZ)
+#define PARACHUTE_STEP SCALAR_FINE(PARACHUTE_SPEED / SIM_HZ)
+
+// The accumulator counts in 1/(1000 * SIM_HZ) s, so that whole ms add up exactly
+#define STEP_UNITS 1000
+// Catching up after a long stall is capped, the rest of the stall is dropped
+#define MAX_STEPS_PER_TICK 8
+#define MAX_CATCH_UP_MS    (MAX_STEPS_PER_TICK * 1000 / SIM_HZ)
+
+// File local: main.c keeps its own clocks, the simulation state must not alias them
+static uint32_t last_tick_ms     = 0;
+static uint16_t step_accumulator = 0;
+
+// Simulation clock
+static uint32_t steps           = 0;
+static uint32_t last_shot_step  = 0;
+static uint32_t last_chute_step = 0;
+static uint8_t  bullets_steps   = 0;
+
+// Shared by every entity: they all get the same whole units at a given step
+static uint8_t gravity_carry   = 0;
+static uint8_t parachute_carry = 0;
 
 uint8_t score   = 0;
 uint8_t bullets = 0;
 
 #define RANDOM_LEN 20
-uint8_t randoms[RANDOM_LEN] = {12, 85, 3,  67, 91, 28, 54, 76, 19, 43,
-                               8,  62, 37, 89, 15, 71, 46, 23, 58, 94};
+static uint8_t randoms[RANDOM_LEN] = {12, 85, 3,  67, 91, 28, 54, 76, 19, 43,
+                                      8,  62, 37, 89, 15, 71, 46, 23, 58, 94};
 
 void init_game() {
-    for (uint8_t i = 0; i < CANNON_ENTITIES; i++) {
-        entities[i].variant = CANNON_POINTER;
-    }
-
-    entities_len = CANNON_ENTITIES;
+    // Also resets the state, so that the host build can restart a lost game
+    last_tick_ms     = 0;
+    step_accumulator = 0;
+    steps            = 0;
+    last_shot_step   = 0;
+    last_chute_step  = 0;
+    bullets_steps    = 0;
+    gravity_carry    = 0;
+    parachute_carry  = 0;
+    score            = 0;
+    bullets          = 0;
+
+    init_entities();
 }
 
-void delete_entity(uint8_t index) {
-    entities[index] = entities[entities_len - 1];
-    entities_len--;
+boolean out_of_screen(scalar_t x, scalar_t y) {
+    return x < 0 || x >= SCALAR_INT(SCREENX) || y < 0 || y >= SCALAR_INT(SCREENY);
 }
 
-uint8_t spawn_entity_non_init() {
-    if (entities_len >= MAX_ENTITIES_LEN) {
-        throw_error(GAME_MAX_ENTITIES_REACHED);
-    }
-    return entities_len++;
-}
+void simulate_step(aim_t aim, boolean shoot_pressed) {
+    steps++;
 
-void process_tick(uint32_t current_ms, float angle_rad, boolean shoot_pressed) {
-    if (last_tick == 0) {
-        last_tick = current_ms;
-        return;
-    }
-
-    uint32_t delta         = current_ms - last_tick;
-    float    delta_seconds = delta / 1000.0;
-    last_tick              = current_ms;
-
-    // angle_rad             = fmaxf(0, fminf(angle_rad, M_PI));
-    float aim_component_x = cosf((float) angle_rad);
-    float aim_component_y = sinf((float) angle_rad);
-
-    float len = ((float) SCREENX) / 5 / 4;
+    scalar_t aim_up = aim.y > 0 ? aim.y : 0;
 
     for (uint8_t i = 0; i < CANNON_ENTITIES; i++) {
-        entities[i].pos_x = SCREENX / 2.0 + aim_component_x * (i + 1);
-        entities[i].pos_y = SCREENY * 1.0 - fmaxf(aim_component_y, 0) * (i + 1);
+        cannon.pos_x[i] = SCALAR(SCREENX / 2.0f) + aim.x * (i + 1);
+        cannon.pos_y[i] = SCALAR_INT(SCREENY) - aim_up * (i + 1);
     }
 
-    bullets_time += delta;
-    bullets += bullets_time / REGEN_TIME_MS;
-    bullets_time %= REGEN_TIME_MS;
+    if (++bullets_steps == REGEN_STEPS) {
+        bullets_steps = 0;
+        bullets++;
+    }
 
     if (bullets > MAX_AMMO) {
         score += bullets - MAX_AMMO;
         bullets = MAX_AMMO;
     }
 
-    // Process physics, skip cannon
-    for (uint8_t i = CANNON_ENTITIES; i < entities_len; i++) {
-        boolean dead = false;
-
-        // Apply gravity only to projectiles
-        if (entities[i].variant == PROJ) {
-            entities[i].speed_y -= G * delta_seconds;
-        } else if (entities[i].variant == PARACHUTE) {
-            for (uint8_t j = 1; j < entities_len; j++) {
-                if (entities[j].variant == PROJ) {
-                    float dx                 = fabsf(entities[i].pos_x - entities[j].pos_x);
-                    float dy                 = fabsf(entities[i].pos_y - entities[j].pos_y);
-                    float manhattan_distance = dx + dy;
-
-                    if (manhattan_distance <= 2.0f) {
-                        dead = true;
-                        score++;
-                        break;
-                    }
-                }
-            }
-        }
+    // Gravity applies only to projectiles
+    scalar_t gravity = SCALAR_TAKE_FINE(GRAVITY_STEP, &gravity_carry);
+    for (uint8_t i = 0; i < projectiles.len; i++) {
+        projectiles.speed_y[i] -= gravity;
 
-        if (!dead) {
-            // Update position based on velocity
-            entities[i].pos_x += entities[i].speed_x * delta_seconds;
-            entities[i].pos_y -= entities[i].speed_y * delta_seconds;
+        scalar_fine_t move_x = SCALAR_MUL_DELTA_FINE(projectiles.speed_x[i], SIM_DELTA);
+        scalar_fine_t move_y = SCALAR_MUL_DELTA_FINE(projectiles.speed_y[i], SIM_DELTA);
+        projectiles.pos_x[i] += SCALAR_TAKE_FINE(move_x, &projectiles.carry_x[i]);
+        projectiles.pos_y[i] -= SCALAR_TAKE_FINE(move_y, &projectiles.carry_y[i]);
+
+        // Hide projectile if out of screen
+        if (out_of_screen(projectiles.pos_x[i], projectiles.pos_y[i])) {
+            delete_projectile(i);
+            i--;
         }
+    }
 
+    // Projectiles stay where they are until the next step
+    collision_build();
 
-        // Check bounds and hide entity if out of screen
-        if (entities[i].pos_x < 0 || entities[i].pos_x >= SCREENX || entities[i].pos_y < 0 ||
-            entities[i].pos_y >= SCREENY || dead) {
-            if (entities[i].variant == PARACHUTE && entities[i].pos_y >= SCREENY) {
-                throw_error(LOSER);
-            }
-            delete_entity(i);
+    scalar_t parachute_fall = SCALAR_TAKE_FINE(PARACHUTE_STEP, &parachute_carry);
+    for (uint8_t i = 0; i < parachutes.len; i++) {
+        if (collision_hit(parachutes.pos_x[i], parachutes.pos_y[i])) {
+            score++;
+            delete_parachute(i);
             i--;
+            continue;
+        }
+
+        parachutes.pos_y[i] -= parachute_fall;
+
+        if (parachutes.pos_y[i] >= SCALAR_INT(SCREENY)) {
+            throw_error(LOSER);
         }
     }
 
-    if (last_chute_spawned + PARACHUTE_SPAWN_MS < current_ms) {
-        uint8_t index = spawn_entity_non_init();
+    if (last_chute_step + PARACHUTE_SPAWN_STEPS < steps) {
+        uint8_t index = spawn_parachute();
 
-        last_chute_spawned = current_ms;
+        last_chute_step = steps;
 
-        entities[index] =
-            (entity_t) {.variant = PARACHUTE,
-                        // Cannon as initial pos
-                        .pos_x   = randoms[current_ms % RANDOM_LEN] * (uint8_t) SCREENX / 100.,
-                        .pos_y   = 1,
-                        .speed_x = 0,
-                        .speed_y = PARACHUTE_SPEED};
+        parachutes.pos_x[index] = SCALAR_RATIO(randoms[steps % RANDOM_LEN] * SCREENX, 100);
+        parachutes.pos_y[index] = SCALAR_INT(1);
     }
 
     // Shoot?
-    if (shoot_pressed && last_shot_ms + RECHARGE_TIME_MS < current_ms && bullets > 0) {
+    if (shoot_pressed && last_shot_step + RECHARGE_STEPS < steps && bullets > 0) {
         bullets--;
-        uint8_t index = spawn_entity_non_init();
+        uint8_t index = spawn_projectile();
 
         // Shoot!
-        last_shot_ms = current_ms;
-
-        entities[index] = (entity_t) {.variant = PROJ,
-                                      // Cannon as initial pos
-                                      .pos_x   = entities[CANNON_ENTITIES - 1].pos_x,
-                                      .pos_y   = entities[CANNON_ENTITIES - 1].pos_y,
-                                      .speed_x = INITIAL_PROJ_SPEED * aim_component_x,
-                                      .speed_y = INITIAL_PROJ_SPEED * aim_component_y};
+        last_shot_step = steps;
+
+        // Cannon as initial pos
+        projectiles.pos_x[index]   = cannon.pos_x[CANNON_ENTITIES - 1];
+        projectiles.pos_y[index]   = cannon.pos_y[CANNON_ENTITIES - 1];
+        projectiles.speed_x[index] = SCALAR_MUL(SCALAR(INITIAL_PROJ_SPEED), aim.x);
+        projectiles.speed_y[index] = SCALAR_MUL(SCALAR(INITIAL_PROJ_SPEED), aim.y);
+    }
+}
+
+void process_tick(uint32_t current_ms, aim_t aim, boolean shoot_pressed) {
+    if (last_tick_ms == 0) {
+        last_tick_ms = current_ms;
+        return;
+    }
+
+    uint32_t elapsed_ms = current_ms - last_tick_ms;
+    last_tick_ms        = current_ms;
+
+    if (elapsed_ms > MAX_CATCH_UP_MS) {
+        elapsed_ms = MAX_CATCH_UP_MS;
+    }
+
+    // The inputs hold for every step of the tick
+    step_accumulator += elapsed_ms * SIM_HZ;
+    while (step_accumulator >= STEP_UNITS) {
+        step_accumulator -= STEP_UNITS;
+        simulate_step(aim, shoot_pressed);
     }
 }
 
-typedef struct {
-    uint8_t color;
-    uint8_t x_pos;
-    uint8_t y_pos;
-} colored_pixels_t;
+#if MAX_ENTITIES_LEN > FRAME_MAX_PIXELS
+    #error "A frame cannot hold every entity"
+#endif
 
 colored_pixels_t colored_pixels[MAX_ENTITIES_LEN];
 uint8_t          num_drawable_pixels;
 
-// Tracks the sent pixel
-uint8_t current_pixel_idx = 0;
-// Tracks the state of sending a frame
-uint8_t frame_send_status;
-// Used as the current row index (Y-coordinate on screen) during frame sending
-uint8_t x_send_status;
-// Used as the current byte column index in the current row during frame sending
-uint8_t y_send_status;
-
-volatile boolean generator_f(uint8_t *data) {
-    switch (frame_send_status) {
-        case 0:
-            *data = SET_COMMAND(FRAME_START);
-            frame_send_status++;
-            x_send_status = 0; // current_row
-            y_send_status = 0; // current_byte_col
-            return true;
-
-        case 1: {
-            if (x_send_status == SCREENY) {
-                *data = SET_COMMAND(FRAME_END);
-                frame_send_status++;
-                return true;
-            }
-
-            uint8_t current_row      = x_send_status;
-            uint8_t current_byte_col = y_send_status;
-            uint8_t byte_to_send     = 0;
-
-            // Iterate through the sorted colored_pixels to find pixels for the current byte
-            // current_pixel_idx points to the next pixel in colored_pixels to consider
-            while (current_pixel_idx < num_drawable_pixels) {
-                colored_pixels_t *pixel = &colored_pixels[current_pixel_idx];
-
-                if (pixel->y_pos < current_row) {
-                    // This pixel is for a previous row that we've already passed. Skip it.
-                    current_pixel_idx++;
-                    continue;
-                }
-
-                if (pixel->y_pos > current_row) {
-                    // This pixel (and all subsequent ones due to sorting) are for future rows.
-                    // So, no more contributions from colored_pixels for the current_row.
-                    // The current byte_to_send (which is likely 0) is complete for this (row,
-                    // byte_col).
-                    break;
-                }
-
-                // At this point, pixel->y_pos == current_row. Check its byte column.
-                // Calculate which byte column this pixel falls into.
-                uint8_t pixel_byte_col_for_pixel = pixel->x_pos / COLORS_PER_BYTE;
-
-                if (pixel_byte_col_for_pixel < current_byte_col) {
-                    // This pixel is for a previous byte column in the current_row. Skip it.
-                    current_pixel_idx++;
-                    continue;
-                }
-
-                if (pixel_byte_col_for_pixel > current_byte_col) {
-                    // This pixel (and others after it on this row, if any) are for future byte
-                    // columns. So, no more contributions from colored_pixels for the
-                    // current_byte_col. The current byte_to_send is complete.
-                    break;
-                }
-
-                // At this point, pixel->y_pos == current_row AND
-                // pixel_byte_col_for_pixel == current_byte_col.
-                // This means the pixel at colored_pixels[current_pixel_idx]
-                // belongs in the current byte_to_send!
-
-                uint8_t color_value = pixel->color;
-                // Determine the pixel's position *within* the current byte
-                // e.g., is it the 0th, 1st, or Nth color slot in this byte
-                uint8_t pixel_pos_in_byte = pixel->x_pos % COLORS_PER_BYTE;
-
-                // Shift the color into the correct bit position(s) within the byte.
-                // This assumes BITS_PER_COLOR and COLORS_PER_BYTE are set up so that
-                // (color_value << (BITS_PER_COLOR * pixel_pos_in_byte)) fits within
-                // the bits allocated for color data (e.g., lower 7 bits if MSB is command).
-                uint8_t shifted_color = color_value << (BITS_PER_COLOR * pixel_pos_in_byte);
-
-                byte_to_send |= shifted_color; // Combine with any other pixels in this byte
-
-                current_pixel_idx++; // Consume this pixel, move to the next in colored_pixels
-                                     // to check if it also fits in the current byte_to_send.
-            }
-
-            *data = byte_to_send; // Assign the fully composed byte (MSB should be 0 for data)
-
-            // Advance iterators to the next byte position in the frame
-            y_send_status++; // Move to the next byte column in the current row
-            if (y_send_status ==
-                (SCREENX / COLORS_PER_BYTE)) { // Reached the end of byte columns for this row
-                y_send_status = 0; // Reset byte column index to the beginning of a new row
-                x_send_status++;   // Move to the next row
-            }
-            return true; // Indicate that this data byte is valid
-        }
-
-        default:
-            return false;
+// colored_pixels is built with a counting sort by row: linear in the number of entities, bounded
+// by SCREENY. During the build, row_start[y] is the next free slot of row y
+uint8_t row_start[SCREENY + 1];
+
+#ifdef INTERPOLATE_FRAMES
+// Time simulated since the last step, moving entities are drawn that far ahead
+delta_t render_lead;
+#endif
+
+// Pixel where entity `i` is drawn, false if out of screen. `speed_x` is 0 for static entities
+boolean entity_pixel(scalar_t *pos_x,
+                     scalar_t *pos_y,
+                     scalar_t *speed_x,
+                     scalar_t *speed_y,
+                     uint8_t   i,
+                     uint8_t  *pixel_x,
+                     uint8_t  *pixel_y) {
+    scalar_t x = pos_x[i];
+    scalar_t y = pos_y[i];
+#ifdef INTERPOLATE_FRAMES
+    if (speed_x) {
+        x += SCALAR_MUL_DELTA(speed_x[i], render_lead);
+        y -= SCALAR_MUL_DELTA(speed_y[i], render_lead);
     }
+#endif
+    *pixel_x = SCALAR_TO_PIXEL(x);
+    *pixel_y = SCALAR_TO_PIXEL(y);
+
+    // Ensure pixels are within screen boundaries after casting
+    return *pixel_x < SCREENX && *pixel_y < SCREENY;
 }
 
-void start_sending_frame() {
-    num_drawable_pixels = 0; // Reset count for the current frame
-
-    // 1. Initialize colored_pixels from entities
-    // Iterate through all active entities
-    for (uint8_t i = 0; i < entities_len; i++) {
-        // Safety break: ensure we don't write out of bounds for colored_pixels.
-        // This should not be hit if MAX_ENTITIES_LEN is consistent.
-        if (num_drawable_pixels >= MAX_ENTITIES_LEN) {
-            break;
+// Pass 1: count the visible pixels of each row, one slot ahead for the prefix sum
+void count_drawable_pixels(scalar_t *pos_x,
+                           scalar_t *pos_y,
+                           scalar_t *speed_x,
+                           scalar_t *speed_y,
+                           uint8_t   len) {
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t pixel_x, pixel_y;
+        if (entity_pixel(pos_x, pos_y, speed_x, speed_y, i, &pixel_x, &pixel_y)) {
+            row_start[pixel_y + 1]++;
         }
+    }
+}
 
-        uint8_t pixel_x = (uint8_t) entities[i].pos_x;
-        uint8_t pixel_y = (uint8_t) entities[i].pos_y;
-
-        // Ensure pixels are within screen boundaries after casting
-        if (pixel_x < SCREENX && pixel_y < SCREENY) {
-            colored_pixels[num_drawable_pixels].x_pos = pixel_x;
-            colored_pixels[num_drawable_pixels].y_pos = pixel_y;
-            colored_pixels[num_drawable_pixels].color = entities[i].variant;
-            num_drawable_pixels++;
+// Pass 2: same filter as pass 1, place every pixel in its row
+void place_drawable_pixels(scalar_t        *pos_x,
+                           scalar_t        *pos_y,
+                           scalar_t        *speed_x,
+                           scalar_t        *speed_y,
+                           uint8_t          len,
+                           entity_variant_t color) {
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t pixel_x, pixel_y;
+        if (entity_pixel(pos_x, pos_y, speed_x, speed_y, i, &pixel_x, &pixel_y)) {
+            colored_pixels_t *pixel = &colored_pixels[row_start[pixel_y]++];
+            pixel->x_pos            = pixel_x;
+            pixel->y_pos            = pixel_y;
+            pixel->color            = color;
         }
     }
+}
 
-    // 2. Sort colored_pixels by y_pos, then by x_pos (Bubble Sort)
-    //    Only sort the valid part of the array, i.e., up to num_drawable_pixels.
-    if (num_drawable_pixels > 1) { // Only sort if there's more than one element
-        for (uint8_t i = 0; i < num_drawable_pixels - 1; i++) {
-            for (uint8_t j = 0; j < num_drawable_pixels - 1 - i; j++) {
-                // Compare y_pos first
-                if (colored_pixels[j].y_pos > colored_pixels[j + 1].y_pos ||
-                    // If y_pos is the same, compare x_pos
-                    (colored_pixels[j].y_pos == colored_pixels[j + 1].y_pos &&
-                     colored_pixels[j].x_pos > colored_pixels[j + 1].x_pos)) {
-                    // Swap elements
-                    colored_pixels_t temp = colored_pixels[j];
-                    colored_pixels[j]     = colored_pixels[j + 1];
-                    colored_pixels[j + 1] = temp;
-                }
-            }
+void start_sending_frame() {
+    // 1. Bucket colored_pixels by row, one variant at a time.
+    // The store caps add up to MAX_ENTITIES_LEN, colored_pixels cannot overflow
+    for (uint8_t i = 0; i <= SCREENY; i++) {
+        row_start[i] = 0;
+    }
+
+#ifdef INTERPOLATE_FRAMES
+    render_lead = DELTA_SCALE(SIM_DELTA, step_accumulator, STEP_UNITS);
+#endif
+
+    // Only the projectiles move fast enough for the lead to show, parachutes move ~1/40 px/step
+    count_drawable_pixels(cannon.pos_x, cannon.pos_y, 0, 0, CANNON_ENTITIES);
+    count_drawable_pixels(projectiles.pos_x,
+                          projectiles.pos_y,
+                          projectiles.speed_x,
+                          projectiles.speed_y,
+                          projectiles.len);
+    count_drawable_pixels(parachutes.pos_x, parachutes.pos_y, 0, 0, parachutes.len);
+
+    for (uint8_t i = 1; i <= SCREENY; i++) {
+        row_start[i] += row_start[i - 1];
+    }
+    num_drawable_pixels = row_start[SCREENY];
+
+    place_drawable_pixels(cannon.pos_x, cannon.pos_y, 0, 0, CANNON_ENTITIES, CANNON_POINTER);
+    place_drawable_pixels(projectiles.pos_x,
+                          projectiles.pos_y,
+                          projectiles.speed_x,
+                          projectiles.speed_y,
+                          projectiles.len,
+                          PROJ);
+    place_drawable_pixels(parachutes.pos_x, parachutes.pos_y, 0, 0, parachutes.len, PARACHUTE);
+
+    // 2. Sort each row by x_pos (Insertion Sort).
+    //    Rows are already in order, so elements only move within their row: rows hold a handful
+    //    of pixels at most, this is linear in practice.
+    for (uint8_t i = 1; i < num_drawable_pixels; i++) {
+        colored_pixels_t pixel = colored_pixels[i];
+        uint8_t          j     = i;
+
+        while (j > 0 && colored_pixels[j - 1].y_pos == pixel.y_pos &&
+               colored_pixels[j - 1].x_pos > pixel.x_pos) {
+            colored_pixels[j] = colored_pixels[j - 1];
+            j--;
         }
+        colored_pixels[j] = pixel;
     }
 
-    // Reset frame send status and the current_pixel_idx for generator_f
-    frame_send_status = 0;
-    current_pixel_idx = 0; // This is the 'global pointer' for generator_f to iterate colored_pixels
-    send_data_generator_f(generator_f);
+    frame_send(colored_pixels, num_drawable_pixels);
 }
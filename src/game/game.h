@@ -2,14 +2,21 @@
 #define GAME_H
 
 #include "../utils/utils.h"
+#include "aim.h"
 #include <stdint.h>
 
 extern uint8_t score;
 extern uint8_t bullets;
 
+// Fixed simulation rate: process_tick() runs as many steps as the elapsed time covers, so the
+// physics do not depend on how long the previous frame took to be sent.
+// Define INTERPOLATE_FRAMES to draw the projectiles where they are between two steps
+#define SIM_HZ 240
+
 void init_game();
-// angle between 0 and PI, in radians
-void process_tick(uint32_t, float, boolean);
+void process_tick(uint32_t, aim_t, boolean);
+// Exactly one step, the same inputs always give the same game
+void simulate_step(aim_t, boolean);
 
 void start_sending_frame();
 
@@ -0,0 +1,67 @@
+#ifndef _PHYSICS_H
+#define _PHYSICS_H
+
+// Number type used by the entity math.
+//
+// Fixed point (Q8.8) by default. Define FLOAT_PHYSICS to get the original float implementation:
+// slow on the AVR, kept as a reference (e.g. `CFLAGS=-DFLOAT_PHYSICS ./bench.sh`). check.sh
+// checks that both stay within tolerance of each other.
+//
+// Amounts added at every step are scalar_fine_t: SCALAR_TAKE_FINE(fine, &carry) gives what can be
+// added to a scalar_t now and keeps the rest in `carry` (a uint8_t) for the next step. The float
+// build has nothing to carry
+
+#include "../generated.h"
+#include "fixed.h"
+#include <math.h>
+#include <stdint.h>
+
+#ifdef FLOAT_PHYSICS
+
+typedef float scalar_t;
+// Seconds
+typedef float delta_t;
+// Per step amounts, see SCALAR_TAKE_FINE
+typedef float scalar_fine_t;
+
+    #define SCALAR(x)                       ((scalar_t) (x))
+    #define SCALAR_INT(x)                   ((scalar_t) (x))
+    #define SCALAR_RATIO(num, den)          ((scalar_t) (num) / (den))
+    #define SCALAR_TO_PIXEL(x)              ((uint8_t) (x))
+    #define SCALAR_MUL(a, b)                ((a) * (b))
+    #define SCALAR_MUL_DELTA(x, delta)      ((x) * (delta))
+    #define SCALAR_ABS(x)                   fabsf(x)
+    #define DELTA_FROM_MS(ms)               ((ms) / 1000.0f)
+    #define DELTA_FROM_HZ(hz)               (1.0f / (hz))
+    #define DELTA_SCALE(dt, num, den)       ((dt) * (num) / (den))
+    #define SCALAR_FINE(x)                  ((scalar_fine_t) (x))
+    #define SCALAR_MUL_DELTA_FINE(x, delta) ((x) * (delta))
+    #define SCALAR_TAKE_FINE(fine, carry)   (fine)
+
+#else
+
+    #if SCREENX >= 128 || SCREENY >= 128
+        #error "Q8.8 positions only cover 127 pixels, build with FLOAT_PHYSICS"
+    #endif
+
+typedef fixed_t      scalar_t;
+typedef fixed_dt_t   delta_t;
+typedef fixed_fine_t scalar_fine_t;
+
+    #define SCALAR(x)                       FIXED_FROM_FLOAT(x)
+    #define SCALAR_INT(x)                   FIXED_FROM_INT(x)
+    #define SCALAR_RATIO(num, den)          ((scalar_t) ((int32_t) (num) * FIXED_ONE / (den)))
+    #define SCALAR_TO_PIXEL(x)              ((uint8_t) FIXED_TO_INT(x))
+    #define SCALAR_MUL(a, b)                fixed_mul(a, b)
+    #define SCALAR_MUL_DELTA(x, delta)      fixed_mul_dt(x, delta)
+    #define SCALAR_ABS(x)                   fixed_abs(x)
+    #define DELTA_FROM_MS(ms)               fixed_dt_from_ms(ms)
+    #define DELTA_FROM_HZ(hz)               FIXED_DT_FROM_HZ(hz)
+    #define DELTA_SCALE(dt, num, den)       ((delta_t) ((uint32_t) (dt) * (num) / (den)))
+    #define SCALAR_FINE(x)                  FIXED_FINE_FROM_FLOAT(x)
+    #define SCALAR_MUL_DELTA_FINE(x, delta) fixed_mul_dt_fine(x, delta)
+    #define SCALAR_TAKE_FINE(fine, carry)   fixed_take_fine(fine, carry)
+
+#endif
+
+#endif
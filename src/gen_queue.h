@@ -1,55 +1,115 @@
 #ifndef DECLARE_QUEUE_H
 #define DECLARE_QUEUE_H
 
-#define DECLARE_QUEUE(name, data_type, len_type, size)                                             \
-    data_type name##_queue[size];                                                                  \
-    len_type  name##_head = 0;                                                                     \
-    len_type  name##_tail = 0;                                                                     \
+// Single producer, single consumer ring buffer, e.g. main loop -> ISR or ISR -> main loop.
+//
+// `size` must be a power of two (at most 128): indices wrap with a mask instead of a division.
+// Head and tail are free running 8 bit counters, so all `size` slots are usable and
+// `tail - head` is the number of queued elements.
+//
+// Only the producer writes the tail and only the consumer writes the head. Each side publishes its
+// index with release semantics after touching the data, and reads the other side's index with
+// acquire semantics: no critical section is needed, as long as there is only one producer and one
+// consumer.
+
+#define QUEUE_LOAD(index)         __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define QUEUE_STORE(index, value) __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+#define DECLARE_QUEUE(name, data_type, size)                                                       \
+    _Static_assert((size) > 0 && (size) <= 128 && ((size) & ((size) - 1)) == 0,                    \
+                   #name " size must be a power of two, at most 128");                             \
+                                                                                                   \
+    data_type        name##_queue[size];                                                           \
+    volatile uint8_t name##_head = 0;                                                              \
+    volatile uint8_t name##_tail = 0;                                                              \
+                                                                                                   \
+    uint8_t name##_len() {                                                                         \
+        return (uint8_t) (QUEUE_LOAD(name##_tail) - QUEUE_LOAD(name##_head));                      \
+    }                                                                                              \
+                                                                                                   \
+    boolean name##_empty() {                                                                       \
+        return name##_len() == 0;                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    /* Producer side */                                                                            \
                                                                                                    \
     boolean name##_enqueue(data_type data) {                                                       \
-        len_type next_tail = (name##_tail + 1) % size;                                             \
-        if (next_tail == name##_head) {                                                            \
+        uint8_t tail = name##_tail;                                                                \
+        if ((uint8_t) (tail - QUEUE_LOAD(name##_head)) == (size)) {                                \
             return false;                                                                          \
         }                                                                                          \
-        name##_queue[name##_tail] = data;                                                          \
-        name##_tail               = next_tail;                                                     \
+        name##_queue[tail & ((size) - 1)] = data;                                                  \
+        QUEUE_STORE(name##_tail, (uint8_t) (tail + 1));                                            \
         return true;                                                                               \
     }                                                                                              \
                                                                                                    \
-    boolean name##_enqueue_n(data_type *data, len_type len) {                                      \
-        len_type available_space = (name##_head - name##_tail - 1 + size) % size;                  \
-        if (len > available_space) {                                                               \
+    /* All or nothing, copied as (at most) two contiguous spans */                                 \
+    boolean name##_enqueue_n(const data_type *data, uint8_t len) {                                 \
+        uint8_t tail = name##_tail;                                                                \
+        if (len > (size) - (uint8_t) (tail - QUEUE_LOAD(name##_head))) {                           \
             return false;                                                                          \
         }                                                                                          \
-        for (len_type i = 0; i < len; i++) {                                                       \
-            name##_queue[name##_tail] = data[i];                                                   \
-            name##_tail               = (name##_tail + 1) % size;                                  \
+        uint8_t start = tail & ((size) - 1);                                                       \
+        uint8_t first = len < (size) - start ? len : (size) - start;                               \
+        for (uint8_t i = 0; i < first; i++) {                                                      \
+            name##_queue[start + i] = data[i];                                                     \
         }                                                                                          \
+        for (uint8_t i = first; i < len; i++) {                                                    \
+            name##_queue[i - first] = data[i];                                                     \
+        }                                                                                          \
+        QUEUE_STORE(name##_tail, (uint8_t) (tail + len));                                          \
         return true;                                                                               \
     }                                                                                              \
                                                                                                    \
+    /* Consumer side */                                                                            \
+                                                                                                   \
     boolean name##_dequeue(data_type *data) {                                                      \
-        if (name##_head == name##_tail) {                                                          \
+        uint8_t head = name##_head;                                                                \
+        if (head == QUEUE_LOAD(name##_tail)) {                                                     \
             return false;                                                                          \
         }                                                                                          \
         if (data) {                                                                                \
-            *data = name##_queue[name##_head];                                                     \
+            *data = name##_queue[head & ((size) - 1)];                                             \
         }                                                                                          \
-                                                                                                   \
-        name##_head = (name##_head + 1) % size;                                                    \
+        QUEUE_STORE(name##_head, (uint8_t) (head + 1));                                            \
         return true;                                                                               \
     }                                                                                              \
                                                                                                    \
-    boolean name##_first(data_type *data) {                                                        \
-        if (name##_head == name##_tail) {                                                          \
-            return false; /* Queue is empty */                                                     \
+    /* Up to `max_len` elements, returns how many were dequeued */                                 \
+    uint8_t name##_dequeue_n(data_type *data, uint8_t max_len) {                                   \
+        uint8_t head = name##_head;                                                                \
+        uint8_t len  = (uint8_t) (QUEUE_LOAD(name##_tail) - head);                                 \
+        if (len > max_len) {                                                                       \
+            len = max_len;                                                                         \
         }                                                                                          \
-        *data = name##_queue[name##_head];                                                         \
-        return true;                                                                               \
+        uint8_t start = head & ((size) - 1);                                                       \
+        uint8_t first = len < (size) - start ? len : (size) - start;                               \
+        for (uint8_t i = 0; i < first; i++) {                                                      \
+            data[i] = name##_queue[start + i];                                                     \
+        }                                                                                          \
+        for (uint8_t i = first; i < len; i++) {                                                    \
+            data[i] = name##_queue[i - first];                                                     \
+        }                                                                                          \
+        QUEUE_STORE(name##_head, (uint8_t) (head + len));                                          \
+        return len;                                                                                \
     }                                                                                              \
                                                                                                    \
-    boolean name##_empty() {                                                                       \
-        return name##_head == name##_tail;                                                         \
+    /* In place access to the oldest element, 0 if empty. Valid until it is dequeued */            \
+    data_type *name##_front() {                                                                    \
+        uint8_t head = name##_head;                                                                \
+        if (head == QUEUE_LOAD(name##_tail)) {                                                     \
+            return 0; /* Queue is empty */                                                         \
+        }                                                                                          \
+        return &name##_queue[head & ((size) - 1)];                                                 \
+    }                                                                                              \
+                                                                                                   \
+    boolean name##_first(data_type *data) {                                                        \
+        data_type *front = name##_front();                                                         \
+        if (!front) {                                                                              \
+            return false;                                                                          \
+        }                                                                                          \
+        *data = *front;                                                                            \
+        return true;                                                                               \
     }
 
 #endif
@@ -10,6 +10,10 @@
 #define SCREENY 60
 #define BAUD 1000000
 #define BITS_PER_COLOR 2
+#define FRAME_MODE_DELTA 1
+#define FRAME_MODE_RLE 2
+#define FRAME_MODE_CHECK 4
+#define FRAME_CHECK_POLY 7
 
 typedef enum __attribute__((packed)) {
     FRAME_START = 0,
@@ -17,10 +21,18 @@ typedef enum __attribute__((packed)) {
     BOOTED = 2,
     SCORE = 3,
     BULLETS = 4,
+    DELTA_FRAME_START = 5,
+    RLE_RUN = 6,
+    FRAME_CHECK = 7,
+    FRAME_STATS = 8,
 } BACKEND_TO_FRONTEND;
 
 typedef enum __attribute__((packed)) {
     BUTTON_PRESS = 0,
+    SET_FRAME_MODE = 1,
+    SET_AIM = 2,
+    RELEASE_AIM = 3,
+    PAUSE = 4,
 } FRONTEND_TO_BACKEND;
 
 #endif
@@ -34,6 +34,43 @@
 
 // https://cdn.sparkfun.com/assets/9/5/f/7/b/HD44780.pdf#page=24
 
+// Rendering is asynchronous: lcd_write_*() only update a shadow of the screen in RAM and mark the
+// cells that changed. lcd_flush() then lets the TWI interrupt stream the dirty cells, a few per
+// frame, without ever waiting on the bus. An LCD byte is 6 bus bytes, and the first nibble of the
+// next one is only latched 3 bus bytes after it (67.5 us at 400 kHz), later than the 37 us the LCD
+// needs to execute it, so no delays are needed either.
+
+#define CELLS (ROWS * COLS)
+
+// Bus time per frame given to the LCD
+#define FLUSH_BUDGET_US 2000
+
+// I2C bytes to send one byte to the LCD
+#define NIBBLES_LEN 6
+
+// Cells looked at (or clean rows skipped) per refill, which runs in the TWI interrupt
+#define SCAN_PER_REFILL (COLS + ROWS)
+
+// DDRAM address of the first cell of each row
+const uint8_t row_address[ROWS] = {0x00, 0x40, 0x14, 0x54};
+
+// What should be on the glass, and which cells differ from what is on it (one bit per cell).
+// dirty_rows has a bit per row written since the scan last started it, so that clean rows are
+// skipped without looking at their cells
+volatile char    shadow[CELLS];
+volatile uint8_t dirty[(CELLS + 7) / 8];
+volatile uint8_t dirty_rows = 0;
+
+// Where lcd_write_*() write
+uint8_t cursor_row = 0;
+uint8_t cursor_col = 0;
+
+// Interrupt side: next cell to look at, where the LCD will write next, bus bytes left this frame
+uint8_t          scan_row      = 0;
+uint8_t          scan_col      = 0;
+uint8_t          glass_address = 0xFF; // Unknown
+volatile uint8_t budget_bytes  = 0;
+
 void throw_error_if_present(ERROR err) {
     if (err) {
         throw_error(err);
@@ -41,96 +78,181 @@ void throw_error_if_present(ERROR err) {
 }
 
 // rs 0:instruction, 1:data
-void lcd_send_2_nibbles(uint8_t cmd, boolean rs) {
+void lcd_nibbles_sequence(uint8_t cmd, boolean rs, uint8_t sequence[NIBBLES_LEN]) {
     uint8_t high_nibble = (cmd & 0xF0) | 0x08 | rs;        // High nibble + backlight + maybe rs
     uint8_t low_nibble  = ((cmd << 4) & 0xF0) | 0x08 | rs; // Low nibble + backlight + maybe rs
 
     // Send both nibbles with enable pulses.
     // The enable bit latches the signal (or something)
-    uint8_t sequence[6];
     sequence[0] = high_nibble;
     sequence[1] = high_nibble | 0x04;  // Set enable bit
     sequence[2] = high_nibble & ~0x04; // Clear enable bit
     sequence[3] = low_nibble;
     sequence[4] = low_nibble | 0x04;  // Set enable bit
     sequence[5] = low_nibble & ~0x04; // Clear enable bit
+}
+
+// Segment of the current transaction, waits if the queue is full. Only used during init
+void lcd_send_2_nibbles(uint8_t cmd, boolean rs) {
+    uint8_t sequence[NIBBLES_LEN];
+    lcd_nibbles_sequence(cmd, rs, sequence);
+    while (!write_two_wires_segment(sequence, NIBBLES_LEN)) {
+        sleep();
+    }
+}
 
-    write_two_wires_start(DISPLAY_I2C_ADDRESS, sequence, 6);
+void advance_scan() {
+    if (scan_col == 0) {
+        // The rest of the row is scanned now. A later write at or before the scan sets it again
+        dirty_rows &= ~(1 << scan_row);
+    }
+    scan_col++;
+    if (scan_col == COLS) {
+        scan_col = 0;
+        scan_row = scan_row == ROWS - 1 ? 0 : scan_row + 1;
+    }
 }
 
+// TWI interrupt: appends as many dirty cells to the transfer as the budget and the queue allow.
+// The scan is bounded to SCAN_PER_REFILL steps, resuming where it stopped. If that is reached with
+// nothing appended, the transfer ends and the next lcd_flush() picks up the rest
+void lcd_refill() {
+    for (uint8_t scanned = 0; scanned < SCAN_PER_REFILL; scanned++) {
+        if (scan_col == 0 && !(dirty_rows & (1 << scan_row))) {
+            scan_row = scan_row == ROWS - 1 ? 0 : scan_row + 1;
+            continue;
+        }
+
+        uint8_t cell = scan_row * COLS + scan_col;
+        uint8_t mask = 1 << (cell & 7);
+
+        if (!(dirty[cell >> 3] & mask)) {
+            advance_scan();
+            continue;
+        }
+
+        // Set DDRAM Address command: 1AAAAAAA (bit 7 = 1, bits 6-0 = address)
+        // Only needed when the cell does not follow the last written one
+        uint8_t address = row_address[scan_row] + scan_col;
+        uint8_t len     = address == glass_address ? NIBBLES_LEN : 2 * NIBBLES_LEN;
+        if (budget_bytes < len || two_wires_free() < len) {
+            // Resume from this cell in the next refill or frame
+            return;
+        }
 
-void write_char_lcd_2004(uint8_t charr) {
-    lcd_send_2_nibbles(charr, true);
+        // Clear before reading: a concurrent write marks the cell dirty again
+        dirty[cell >> 3] &= ~mask;
+
+        uint8_t sequence[2 * NIBBLES_LEN];
+        if (len > NIBBLES_LEN) {
+            lcd_nibbles_sequence(0x80 | address, false, sequence);
+        }
+        lcd_nibbles_sequence(shadow[cell], true, &sequence[len - NIBBLES_LEN]);
+        write_two_wires_append(sequence, len);
+
+        budget_bytes -= len;
+        glass_address = address + 1;
+        advance_scan();
+    }
 }
 
-void lcd_clean() {
-    lcd_send_2_nibbles(0b1, false);
-    sleep_ms(5);
+boolean lcd_pending() {
+    for (uint8_t i = 0; i < sizeof(dirty); i++) {
+        if (dirty[i]) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void lcd_set_cursor(uint8_t row, uint8_t col) {
-    // Validate bounds
-    if (row >= ROWS || col >= COLS) {
-        throw_error(LCD_INVALID_ROW_OR_COL);
+// Sends the whole screen again, from an unknown glass address
+void lcd_mark_all_dirty() {
+    for (uint8_t cell = 0; cell < CELLS; cell++) {
+        dirty[cell >> 3] |= 1 << (cell & 7);
     }
+    dirty_rows    = (1 << ROWS) - 1;
+    glass_address = 0xFF;
+}
+
+void lcd_flush() {
+    // At most 95 bytes: a byte takes at least 21 us (the fastest setting, 444 kHz). On a bus slow
+    // enough for the budget to not even fit one cell (below ~54 kHz), one cell per frame is sent
+    uint16_t bytes = FLUSH_BUDGET_US / two_wires_byte_us();
+    budget_bytes   = bytes < 2 * NIBBLES_LEN ? 2 * NIBBLES_LEN : bytes;
 
+    // A transfer still in progress picks up the new budget by itself
+    if (two_wires_busy()) {
+        return;
+    }
 
-    uint8_t address;
+    // The last transfer is over, join does not wait. Its cells were marked clean when queued, and
+    // the glass address advanced, but some of them may not have reached the LCD
+    if (write_two_wires_join() != ALL_GOOD) {
+        lcd_mark_all_dirty();
+    }
+
+    if (lcd_pending()) {
+        // No data: the refill provides it
+        write_two_wires_start(DISPLAY_I2C_ADDRESS, 0, 0);
+    }
+}
+
+void lcd_put_char(char charr) {
+    if (cursor_col >= COLS) {
+        // Past the end of the row, dropped
+        return;
+    }
+
+    uint8_t cell = cursor_row * COLS + cursor_col;
+    if (shadow[cell] != charr) {
+        shadow[cell] = charr;
+        dirty[cell >> 3] |= 1 << (cell & 7);
+        dirty_rows |= 1 << cursor_row;
+    }
+    cursor_col++;
+}
 
-    // Calculate DDRAM address based on row
-    switch (row) {
-        case 0:
-            address = 0x00 + col;
-            break; // Line 0
-        case 1:
-            address = 0x40 + col;
-            break; // Line 1
-        case 2:
-            address = 0x14 + col;
-            break; // Line 2
-        case 3:
-            address = 0x54 + col;
-            break; // Line 3
+void lcd_clean() {
+    for (uint8_t row = 0; row < ROWS; row++) {
+        lcd_set_cursor(row, 0);
+        for (uint8_t col = 0; col < COLS; col++) {
+            lcd_put_char(' ');
+        }
     }
+    lcd_set_cursor(0, 0);
+}
 
-    // Set DDRAM Address command: 1AAAAAAA (bit 7 = 1, bits 6-0 = address)
-    lcd_send_2_nibbles(0x80 | address, false);
+void lcd_set_cursor(uint8_t row, uint8_t col) {
+    // Validate bounds
+    if (row >= ROWS || col >= COLS) {
+        throw_error(LCD_INVALID_ROW_OR_COL);
+    }
 
-    sleep_ms(5);
+    cursor_row = row;
+    cursor_col = col;
 }
 
 
 void lcd_write_string(const char *text) {
     while (*text) {
-        write_char_lcd_2004(*text);
-        sleep_ms(1);
+        lcd_put_char(*text);
         text++;
     }
 }
 
 void lcd_write_uint16(uint16_t value) {
-    char buffer[6]; // Max 5 digits + null terminator for uint16_t (0-65535)
-    int  i = 0;
-
-    // Handle zero case
-    if (value == 0) {
-        buffer[0] = '0';
-        buffer[1] = '\0';
-    } else {
-        // Convert to string (reverse order)
-        uint16_t temp = value;
-        while (temp > 0) {
-            buffer[i++] = '0' + (temp % 10);
-            temp /= 10;
-        }
-        buffer[i] = '\0';
+    // Max 5 digits + null terminator for uint16_t (0-65535), right aligned
+    char buffer[6];
+    int  i = 5;
 
-        // Reverse the string
-        for (int j = 0; j < i / 2; j++) {
-            char temp_char    = buffer[j];
-            buffer[j]         = buffer[i - 1 - j];
-            buffer[i - 1 - j] = temp_char;
-        }
+    buffer[i] = '\0';
+    do {
+        buffer[--i] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (i > 0) {
+        buffer[--i] = ' ';
     }
 
     lcd_write_string(buffer);
@@ -140,6 +262,9 @@ void init_lcd_2004() {
     // Power stabilization delay, apparently important
     sleep_ms(50);
 
+    // The PCF8574 handles fast mode if the pull-ups are strong enough
+    two_wires_negotiate_frequency(DISPLAY_I2C_ADDRESS, TWO_WIRES_FAST_FREQUENCY);
+
     uint8_t current        = 0;
     uint8_t lcd_commands[] = {
         // 3-command reset sequence: https://cdn.sparkfun.com/assets/9/5/f/7/b/HD44780.pdf#page=45
@@ -168,11 +293,20 @@ void init_lcd_2004() {
         0};
 
 
+    // One transaction, the bus is held during the delays
+    write_two_wires_begin(DISPLAY_I2C_ADDRESS);
     while (lcd_commands[current]) {
         lcd_send_2_nibbles(lcd_commands[current], false);
         sleep_ms(10);
         current++;
     }
+    write_two_wires_end();
 
     throw_error_if_present(write_two_wires_join());
+
+    // The glass has just been cleared
+    for (uint8_t i = 0; i < CELLS; i++) {
+        shadow[i] = ' ';
+    }
+    two_wires_set_refill(DISPLAY_I2C_ADDRESS, lcd_refill);
 }
@@ -4,14 +4,22 @@
 #include "../two_wires/tw.h"
 #include "../utils/utils.h"
 
+// Blocking, the only function that waits on the bus
 void init_lcd_2004();
 
+// The functions below only update a copy of the screen in RAM, they never wait.
+// Text past the end of a row is dropped
+
 void lcd_write_string(const char *);
+// Right aligned on 5 characters, so that shorter values overwrite longer ones
 void lcd_write_uint16(uint16_t);
 
 void lcd_clean();
 
 void lcd_set_cursor(uint8_t row, uint8_t col);
 
+// Sends the changed characters in the background, within a bus time budget. Call once per frame
+void lcd_flush();
+
 
 #endif
@@ -1,13 +1,15 @@
 #include "analog/analog.h"
+#include "frame/frame.h"
 #include "game/game.h"
 #include "generated.h"
 #include "lcd2004/lcd2004.h" // For the character LCD
 #include "ports.h"
+#include "remote/remote.h"
+#include "scheduler/scheduler.h"
 #include "serial/serial.h"
 #include "timers/timer.h"
 #include "two_wires/tw.h"
 #include "utils/utils.h"
-#include <math.h>
 #include <stdint.h>
 
 #define PCICR EXPAND_ADDRESS(0x68)
@@ -15,10 +17,173 @@
 #define PCMSK0 EXPAND_ADDRESS(0x6B)
 #define PCMSK1 EXPAND_ADDRESS(0x6C)
 
+// Potentiometer, A1
+#define GAME_AIM_PIN 1
+
 INTERRUPT(default) {
     throw_error(BAD_INTERRUPT);
 }
 
+// Task periods. The game runs at a fixed 60 Hz, sampling the inputs more often than that
+#define GAME_PERIOD_US  16667
+#define INPUT_PERIOD_US 4167
+#define LCD_PERIOD_US   100000
+
+// Lower runs first when several tasks are due at the same time
+enum {
+    INPUT_PRIORITY = 0,
+    GAME_PRIORITY,
+    FRAME_PRIORITY,
+    TELEMETRY_PRIORITY,
+    LCD_PRIORITY,
+};
+
+BIT_NO(GAME_SHOOT_PIN, 4);
+
+// Latest inputs, sampled by the input task
+aim_t   aim;
+boolean pressed = false;
+
+// Game clock, stopped while paused from the frontend
+uint32_t game_ms;
+uint32_t last_game_clock_ms;
+
+// Frames in the current second, and in the last complete one
+uint32_t fps_start_ms;
+uint16_t fps_frames = 0;
+uint16_t fps        = 0;
+
+// Stamped on the last frame by the telemetry task. The frame time is building and encoding it,
+// the wait is for the previous frame to leave: the link is the bottleneck when it grows
+uint32_t frame_ms      = 0;
+uint32_t tick_us       = 0;
+uint32_t frame_us      = 0;
+uint32_t frame_wait_us = 0;
+
+void input_task() {
+    remote_poll();
+
+    uint16_t aim_adc = remote.aim_override ? remote.aim_adc : analog_latest(GAME_AIM_PIN);
+    aim              = aim_from_adc(aim_adc);
+    pressed          = remote.fire || !(PIND & (1 << GAME_SHOOT_PIN));
+}
+
+void game_task() {
+    uint32_t now = get_current_time();
+    if (!remote.paused) {
+        game_ms += now - last_game_clock_ms;
+    }
+    last_game_clock_ms = now;
+
+    // Overlaps with the transmission of the previous frame
+    if (!remote.paused) {
+        MEASURE_TIME_US(elapsed_us) {
+            process_tick(game_ms, aim, pressed);
+        }
+        tick_us = elapsed_us;
+    }
+}
+
+void frame_task() {
+    // Done by frame_send() anyway, waited here to be measured apart from the build
+    MEASURE_TIME_US(wait_us) {
+        frame_join();
+    }
+    frame_wait_us = wait_us;
+
+    // Returns while the frame is still being sent
+    MEASURE_TIME_US(build_us) {
+        start_sending_frame();
+    }
+    frame_us = build_us;
+
+    uint32_t now = get_current_time();
+    frame_ms     = now;
+    fps_frames++;
+    if (now - fps_start_ms >= 1000) {
+        fps          = fps_frames;
+        fps_frames   = 0;
+        fps_start_ms = now;
+    }
+}
+
+// 14 bits as two data bytes, high first
+#define DATA_HIGH(x) SET_DATA((uint8_t) ((x) >> 7))
+#define DATA_LOW(x)  SET_DATA((uint8_t) (x))
+#define MAX_14_BITS  0x3FFF
+
+uint16_t saturate_14_bits(uint32_t value) {
+    return value > MAX_14_BITS ? MAX_14_BITS : value;
+}
+
+void telemetry_task() {
+    uint8_t values[4] = {
+        SET_COMMAND(SCORE),
+        SET_DATA(score),
+        SET_COMMAND(BULLETS),
+        SET_DATA(bullets),
+    };
+
+    // Short enough to be copied, queued right after the frame
+    send_data(values, 4);
+
+    // The time wraps every ~16 s, enough for intervals between frames
+    uint16_t time_ms    = frame_ms & MAX_14_BITS;
+    uint16_t tick_time  = saturate_14_bits(tick_us);
+    uint16_t frame_time = saturate_14_bits(frame_us);
+    uint16_t wait_time  = saturate_14_bits(frame_wait_us);
+
+    uint8_t stats[10] = {
+        SET_COMMAND(FRAME_STATS),
+        SET_DATA(frame_sequence),
+        DATA_HIGH(time_ms),
+        DATA_LOW(time_ms),
+        DATA_HIGH(tick_time),
+        DATA_LOW(tick_time),
+        DATA_HIGH(frame_time),
+        DATA_LOW(frame_time),
+        DATA_HIGH(wait_time),
+        DATA_LOW(wait_time),
+    };
+
+    // Copied as well, leaves a slot of the queue for the other senders
+    send_data(stats, sizeof(stats));
+}
+
+// Debug counters on the LCD, values right aligned
+#define LCD_VALUE_COL 15
+// Second value on the FPS row
+#define LCD_FPS_COL  4
+#define LCD_LATE_COL 10
+
+void init_lcd_stats() {
+    lcd_clean();
+    lcd_set_cursor(0, 0);
+    lcd_write_string("Score");
+    lcd_set_cursor(1, 0);
+    lcd_write_string("FPS");
+    lcd_set_cursor(1, LCD_LATE_COL);
+    lcd_write_string("Late");
+    lcd_set_cursor(2, 0);
+    lcd_write_string("Frame overruns");
+    lcd_set_cursor(3, 0);
+    lcd_write_string("RX dropped");
+}
+
+void lcd_task() {
+    lcd_set_cursor(0, LCD_VALUE_COL);
+    lcd_write_uint16(score);
+    lcd_set_cursor(1, LCD_FPS_COL);
+    lcd_write_uint16(fps);
+    lcd_set_cursor(1, LCD_VALUE_COL);
+    lcd_write_uint16(scheduler_total_overruns());
+    lcd_set_cursor(2, LCD_VALUE_COL);
+    lcd_write_uint16(frame_overruns);
+    lcd_set_cursor(3, LCD_VALUE_COL);
+    lcd_write_uint16(serial_dropped_bytes());
+    lcd_flush();
+}
+
 
 int main(void) {
     init_blinks();
@@ -34,58 +199,38 @@ int main(void) {
     init_ADC();
     init_USART();
     init_two_wires();
+
+    // Enable global interrupts
+    // Before the LCD init, which waits on the timer and on the 2 wires interrupt
+    manage_global_interrupts(true);
+
     init_lcd_2004(); // Requires 2 wires
 
     init_game();
+    init_lcd_stats();
 
     // Useful to find the display
     // scan_i2c_addresses();
 
 
-    // Enable global interrupts
-    manage_global_interrupts(true);
-
-
     uint8_t status = SET_COMMAND(BOOTED);
     send_data(&status, 1);
-    serial_out_join();
 
-    BIT_NO(GAME_SHOOT_PIN, 4);
+    analog_sample_pin(GAME_AIM_PIN);
 
     CLEAR_BIT(DDRD, GAME_SHOOT_PIN);
     // Enable pullup
     SET_BIT(PORTD, GAME_SHOOT_PIN);
 
-    uint32_t last_frame_plus_render_time = 0;
-    uint32_t last_logic_time             = 0;
-    uint32_t last_total_time             = 0;
+    game_ms            = get_current_time();
+    last_game_clock_ms = game_ms;
+    fps_start_ms       = game_ms;
 
-    while (1) {
-        uint16_t angle = analog_read_pin_sync(1);
+    scheduler_add(input_task, INPUT_PERIOD_US, INPUT_PRIORITY);
+    scheduler_add(game_task, GAME_PERIOD_US, GAME_PRIORITY);
+    scheduler_add(frame_task, GAME_PERIOD_US, FRAME_PRIORITY);
+    scheduler_add(telemetry_task, GAME_PERIOD_US, TELEMETRY_PRIORITY);
+    scheduler_add(lcd_task, LCD_PERIOD_US, LCD_PRIORITY);
 
-
-        uint16_t max_angle = (1 << 10) - 1;
-        float    angle_rad = ((float) (angle)) / (max_angle) *M_PI;
-
-        boolean pressed = !(PIND & (1 << GAME_SHOOT_PIN));
-
-
-        process_tick(get_current_time(), angle_rad, pressed);
-
-        start_sending_frame();
-        serial_out_join();
-
-        uint8_t values[4] = {
-            SET_COMMAND(SCORE),
-            SET_DATA(score),
-            SET_COMMAND(BULLETS),
-            SET_DATA(bullets),
-        };
-
-        send_data(values, 4);
-        serial_out_join();
-        // sleep_ms(1000);
-
-        return 0;
-    }
+    scheduler_run();
 }
@@ -0,0 +1,87 @@
+#include "remote.h"
+#include "../frame/frame.h"
+#include "../game/aim.h"
+#include "../generated.h"
+#include "../serial/serial.h"
+
+// A command byte (bit 7 set) starts a command, followed by a fixed number of data bytes.
+// If the USART drops bytes, the next command byte resynchronizes the parser.
+
+#define MAX_COMMAND_DATA 2
+
+remote_t remote = {
+    .fire         = false,
+    .aim_override = false,
+    .aim_adc      = 0,
+    .paused       = false,
+};
+
+// Command being received and its data so far
+boolean             command_pending = false;
+FRONTEND_TO_BACKEND command;
+uint8_t             command_data[MAX_COMMAND_DATA];
+uint8_t             command_data_len;
+
+// Data bytes following each command, 0xFF if unknown
+uint8_t expected_data_len(FRONTEND_TO_BACKEND command) {
+    switch (command) {
+        case BUTTON_PRESS:
+        case SET_FRAME_MODE:
+        case PAUSE:
+            return 1;
+        case SET_AIM:
+            return 2;
+        case RELEASE_AIM:
+            return 0;
+        default:
+            return 0xFF;
+    }
+}
+
+void dispatch_command() {
+    switch (command) {
+        case BUTTON_PRESS:
+            remote.fire = command_data[0] != 0;
+            break;
+        case SET_FRAME_MODE:
+            frame_set_mode(command_data[0]);
+            break;
+        case SET_AIM: {
+            uint16_t adc = (command_data[0] << 7) | command_data[1];
+            if (adc < (1 << ADC_BITS)) {
+                remote.aim_adc      = adc;
+                remote.aim_override = true;
+            }
+            break;
+        }
+        case RELEASE_AIM:
+            remote.aim_override = false;
+            break;
+        case PAUSE:
+            remote.paused = command_data[0] != 0;
+            break;
+        default:
+            break;
+    }
+}
+
+void remote_poll() {
+    uint8_t byte;
+    while (serial_receive(&byte)) {
+        if (GET_BIT(byte, 7)) {
+            command          = SET_DATA(byte);
+            command_data_len = 0;
+            command_pending  = expected_data_len(command) != 0xFF;
+        } else if (command_pending) {
+            command_data[command_data_len++] = byte;
+        } else {
+            // Data without a command, or more data than expected
+            continue;
+        }
+
+        if (command_pending && command_data_len == expected_data_len(command)) {
+            dispatch_command();
+            command_pending = false;
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef _REMOTE_H
+#define _REMOTE_H
+
+#include "../utils/utils.h"
+#include <stdint.h>
+
+// Inputs driven by the frontend (FRONTEND_TO_BACKEND commands), on top of the physical ones
+
+typedef struct {
+    // Held like the physical button, ORed with it
+    boolean fire;
+    // Replaces the potentiometer reading while set
+    boolean  aim_override;
+    uint16_t aim_adc;
+    boolean  paused;
+} remote_t;
+
+extern remote_t remote;
+
+// Non-blocking, decodes every command received since the last call. Meant to be polled once per
+// frame
+void remote_poll();
+
+#endif
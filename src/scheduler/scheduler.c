@@ -0,0 +1,100 @@
+#include "scheduler.h"
+#include "../timers/timer.h"
+
+typedef struct {
+    task_f   run;
+    uint32_t period_us;
+    // Deadline of the next run
+    uint32_t next_us;
+    uint8_t  priority;
+    uint16_t overruns;
+} task_t;
+
+// Sorted by priority
+task_t  tasks[MAX_TASKS];
+uint8_t tasks_len = 0;
+// Task id -> position in `tasks`
+uint8_t task_positions[MAX_TASKS];
+
+// Wrap-safe `a` not after `b`, get_current_us() wraps every ~71 minutes
+boolean not_after(uint32_t a, uint32_t b) {
+    return (int32_t) (a - b) <= 0;
+}
+
+uint8_t scheduler_add(task_f run, uint32_t period_us, uint8_t priority) {
+    if (tasks_len == MAX_TASKS) {
+        throw_error(SCHEDULER_MAX_TASKS_REACHED);
+    }
+
+    // Insertion, keeping the priority order
+    uint8_t position = tasks_len;
+    while (position > 0 && tasks[position - 1].priority > priority) {
+        tasks[position] = tasks[position - 1];
+        position--;
+    }
+    tasks[position] = (task_t) {
+        .run       = run,
+        .period_us = period_us,
+        .next_us   = get_current_us(),
+        .priority  = priority,
+        .overruns  = 0,
+    };
+
+    // Shifted tasks moved one position down
+    for (uint8_t id = 0; id < tasks_len; id++) {
+        if (task_positions[id] >= position) {
+            task_positions[id]++;
+        }
+    }
+    task_positions[tasks_len] = position;
+    return tasks_len++;
+}
+
+void scheduler_run() {
+    while (1) {
+        uint32_t now = get_current_us();
+
+        // The most important due task, and the earliest deadline otherwise
+        task_t  *due      = 0;
+        uint32_t next_due = now + UINT32_MAX / 2;
+        for (uint8_t i = 0; i < tasks_len; i++) {
+            if (not_after(tasks[i].next_us, now)) {
+                due = &tasks[i];
+                break;
+            }
+            if (not_after(tasks[i].next_us, next_due)) {
+                next_due = tasks[i].next_us;
+            }
+        }
+
+        if (!due) {
+            // Any interrupt wakes up, at least the timer overflow every ~1 ms
+            while (!not_after(next_due, get_current_us())) {
+                sleep();
+            }
+            continue;
+        }
+
+        due->run();
+
+        // Keep the phase: fixed rate, not fixed delay
+        due->next_us += due->period_us;
+        if (not_after(due->next_us + due->period_us, get_current_us())) {
+            // More than a whole period late, skip the missed runs instead of bursting
+            due->overruns++;
+            due->next_us = get_current_us() + due->period_us;
+        }
+    }
+}
+
+uint16_t scheduler_overruns(uint8_t task) {
+    return tasks[task_positions[task]].overruns;
+}
+
+uint16_t scheduler_total_overruns() {
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < tasks_len; i++) {
+        total += tasks[i].overruns;
+    }
+    return total;
+}
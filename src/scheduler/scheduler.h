@@ -0,0 +1,25 @@
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include "../utils/utils.h"
+#include <stdint.h>
+
+// Cooperative scheduler: tasks run to completion, from a single loop that sleeps until the next
+// deadline. When several tasks are due, the one with the lowest priority value runs first.
+
+#define MAX_TASKS 6
+
+typedef void (*task_f)();
+
+// Returns the task id. The first run is due immediately
+uint8_t scheduler_add(task_f run, uint32_t period_us, uint8_t priority);
+
+// Never returns
+void scheduler_run();
+
+// Periods skipped because the task started more than one period late
+uint16_t scheduler_overruns(uint8_t task);
+// Summed over all the tasks
+uint16_t scheduler_total_overruns();
+
+#endif
@@ -28,43 +28,66 @@ BIT_NO(RXEN0, 4);
 BIT_NO(UDRIE0, 5);
 BIT_NO(RXCIE0, 7);
 
-DECLARE_QUEUE(usart_in, uint8_t, uint8_t, 10)
+// Drained once per frame by remote_poll()
+DECLARE_QUEUE(usart_in, uint8_t, 32)
+// Received while usart_in was full
+volatile uint16_t usart_in_dropped = 0;
 
-volatile boolean  sending                         = false;
-volatile uint8_t *out_buffer                      = 0;
-volatile uint16_t out_buffer_len                  = 0;
-volatile uint16_t out_buffer_index_to_send        = 0;
-volatile boolean (*generator_function)(uint8_t *) = 0;
+// One queued transfer: a generator, a caller buffer, or a short message copied inline
+typedef struct {
+    volatile boolean (*generator)(uint8_t *);
+    uint8_t *buffer;
+    uint16_t len;
+    uint8_t  inline_data[USART_OUT_INLINE_LEN];
+} usart_message_t;
+
+DECLARE_QUEUE(usart_out, usart_message_t, USART_OUT_MESSAGES)
+
+volatile boolean  sending   = false;
+volatile uint16_t out_index = 0; // Next byte of the first queued message
 
 // Interrupts (MUST DO N-1!!! THEY ARE ACTUALLY 0-BASED):
 // https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-7810-Automotive-Microcontrollers-ATmega328P_Datasheet.pdf#page=49
 
 // USART, RX complete
 INTERRUPT(18) {
+    // Always read UDR0, even when the byte is dropped
     boolean res = usart_in_enqueue(UDR0);
     if (!res) {
-        throw_error(USART_IN_QUEUE_FULL);
+        usart_in_dropped++;
+    }
+}
+
+// Next byte to transmit, chaining to the next message when the first one is done
+boolean next_out_byte(uint8_t *data) {
+    usart_message_t *message;
+    while ((message = usart_out_front())) {
+        if (message->generator) {
+            if (message->generator(data)) {
+                return true;
+            }
+        } else if (out_index < message->len) {
+            *data = message->buffer ? message->buffer[out_index] : message->inline_data[out_index];
+            out_index++;
+            return true;
+        }
+
+        usart_out_dequeue(0);
+        out_index = 0;
     }
+    return false;
 }
 
 // USART, Data Register Empty
 INTERRUPT(19) {
-    if (generator_function) {
-        uint8_t data;
-        boolean data_available = generator_function(&data);
-        if (data_available) {
-            UDR0 = data;
-            return;
-        }
-    } else if (out_buffer_index_to_send < out_buffer_len) {
-        UDR0 = out_buffer[out_buffer_index_to_send];
-        out_buffer_index_to_send++;
+    uint8_t data;
+    if (next_out_byte(&data)) {
         // UDRE interrupt remains enabled and will fire again
         // when UDR0 is ready for the next byte.
+        UDR0 = data;
         return;
     }
 
-
     // Queue is empty, no more data to transmit. Disable interrupt
     CLEAR_BIT(UCSR0B, UDRIE0);
     sending = false;
@@ -83,33 +106,48 @@ void init_USART() {
     UCSR0C = (3 << UCSZ00);
 
     // Enable RX interrupts
-    // SET_BIT(UCSR0B, RXCIE0);
+    SET_BIT(UCSR0B, RXCIE0);
 }
 
-void send_data(uint8_t *buffer, uint16_t len) {
-    if (sending) {
-        throw_error(USART_ALREADY_SENDING);
+// Waits for a free slot if the queue is full.
+// The ISR only ever disables UDRIE after finding the queue empty, so setting it after publishing
+// the message is enough for the message to be sent
+void enqueue_message(usart_message_t *message) {
+    while (!usart_out_enqueue(*message)) {
+        sleep();
     }
     sending = true;
+    SET_BIT(UCSR0B, UDRIE0);
+}
 
-    generator_function       = 0;
-    out_buffer               = buffer;
-    out_buffer_len           = len;
-    out_buffer_index_to_send = 0;
+void send_data(uint8_t *buffer, uint16_t len) {
+    usart_message_t message = {.generator = 0, .buffer = buffer, .len = len};
 
+    if (len <= USART_OUT_INLINE_LEN) {
+        message.buffer = 0;
+        for (uint8_t i = 0; i < len; i++) {
+            message.inline_data[i] = buffer[i];
+        }
+    }
 
-    SET_BIT(UCSR0B, UDRIE0);
+    enqueue_message(&message);
 }
 
 void send_data_generator_f(volatile boolean f(uint8_t *)) {
-    if (sending) {
-        throw_error(USART_ALREADY_SENDING);
-    }
-    sending = true;
+    usart_message_t message = {.generator = f, .buffer = 0, .len = 0};
+    enqueue_message(&message);
+}
 
-    generator_function = f;
+boolean serial_receive(uint8_t *data) {
+    return usart_in_dequeue(data);
+}
 
-    SET_BIT(UCSR0B, UDRIE0);
+uint16_t serial_dropped_bytes() {
+    uint16_t dropped;
+    CRITICAL {
+        dropped = usart_in_dropped;
+    }
+    return dropped;
 }
 
 void serial_out_join() {
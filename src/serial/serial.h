@@ -6,11 +6,26 @@
 #define SET_COMMAND(x) (x | 1 << 7)
 #define SET_DATA(x)    (x & ~(1 << 7))
 
+// Transfers queued at the same time, the UDRE interrupt chains them. Power of two
+#define USART_OUT_MESSAGES 4
+// Messages up to this length are copied, longer buffers must stay valid until sent. FRAME_STATS is
+// the longest copied message
+#define USART_OUT_INLINE_LEN 10
+
 void init_USART();
+
+// Both only wait if the queue is full
 void send_data(uint8_t *, uint16_t);
+// Called from the UDRE interrupt until it returns false. Not reentrant: the generator must not be
+// queued again before it is done
 void send_data_generator_f(volatile boolean (*)(uint8_t *));
 
 // Wait for empty queue
 void serial_out_join();
 
+// Non-blocking, returns whether a byte was available
+boolean serial_receive(uint8_t *data);
+// Bytes received while the input queue was full, they are lost
+uint16_t serial_dropped_bytes();
+
 #endif
@@ -6,6 +6,12 @@
 
 void init_timer0();
 
+// Both are lock-free: they never disable interrupts, so they are safe in critical sections and ISRs
+uint32_t get_current_ms();
+// 4 micros resolution, wraps after ~71 minutes
+uint32_t get_current_us();
+
+// Same as get_current_ms()
 uint32_t get_current_time();
 
 void sleep_ms(uint32_t ms);
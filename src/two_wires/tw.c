@@ -10,13 +10,16 @@
 #define TWBR EXPAND_ADDRESS(0xB8)
 
 // Default prescaler is 1, default TWBR is 0
-// cpu_clock / ( 16 + 2 * TWBR * prescaler )
+// cpu_clock / ( 16 + 2 * TWBR * 4^prescaler )
 // 16000000 / ( 16 + 2 * 72 * 1 ) = 100khz (AI says it's guaranteed to work on
 // I2C displays)
+// 16000000 / ( 16 + 2 * 12 * 1 ) = 400khz
 //
 // For this freq stronger external pull-up resistors are required on SCA and SCL
 // https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-7810-Automotive-Microcontrollers-ATmega328P_Datasheet.pdf#page=264
-#define TWBR_VALUE 72
+//
+// Below 10 the master may not work reliably
+#define MIN_TWBR 10
 
 // TWI Control Register
 #define TWCR EXPAND_ADDRESS(0xBC)
@@ -36,6 +39,7 @@ BIT(TWIE, 0);
 // Ignore prescaler bits
 #define TWI_STATUS_MASK 0xF8
 BIT_NO(TWPS0, 0);
+#define MAX_PRESCALER 3
 
 // I2C Master Transmitter Mode Status Codes
 #define TW_START_TRANSMITTED          0x08 // START condition transmitted
@@ -58,21 +62,38 @@ BIT_NO(TWPS0, 0);
 
 volatile uint8_t slave_address;
 
-DECLARE_QUEUE(tw_out, uint8_t, uint8_t, 50)
+DECLARE_QUEUE(tw_out, uint8_t, 64)
+
+// Between START and STOP
+volatile boolean busy = false;
+// More segments may come, hold the bus instead of sending STOP when tw_out is empty
+volatile boolean transaction_open = false;
+// Holding the bus: TWINT is left set (SCL low) and the interrupt disabled until the next segment
+volatile boolean stalled = false;
+// Called from the ISR when tw_out runs dry, can append more bytes to the same transfer
+void (*volatile refill_callback)() = 0;
+volatile uint8_t refill_slave_address;
 
 volatile ERROR   error;
 volatile uint8_t retries_count;
 #define MAX_RETIRES 10
 
+// Current SCL frequency and bus time of a byte, 18 ms at the slowest setting (489 Hz)
+uint32_t frequency;
+uint16_t byte_us;
+
 // Return whether max_retires exeeded
 // `maybe_can_continue_twcr`: If not 0, TWCR is set if MAX_RETIRES is not reached
 boolean retry_or_error(ERROR maybe_err, uint8_t maybe_can_continue_twcr) {
-    if (retries_count > MAX_RETIRES) {
+    if (retries_count >= MAX_RETIRES) {
         error = maybe_err;
 
         // REALLY REALLY REALLY important to always TWSTO (stop)
         // Hours wasted here count: 4
-        TWCR = DEFAULT_TWCR | TWSTO | TWINT;
+        TWCR             = DEFAULT_TWCR | TWSTO | TWINT;
+        busy             = false;
+        transaction_open = false;
+        return true;
     }
 
     if (maybe_can_continue_twcr) {
@@ -84,9 +105,20 @@ boolean retry_or_error(ERROR maybe_err, uint8_t maybe_can_continue_twcr) {
 }
 
 void send_byte_and_continue() {
-    if (tw_out_empty()) {
+    if (tw_out_empty() && refill_callback && slave_address == refill_slave_address) {
+        // Keep the bus if there is more to send
+        refill_callback();
+    }
+
+    if (tw_out_empty() && transaction_open) {
+        // Wait for the next segment, keeping the bus
+        stalled = true;
+        TWCR    = TWEN;
+
+    } else if (tw_out_empty()) {
         // No data, stop
         TWCR = DEFAULT_TWCR | TWSTO | TWINT;
+        busy = false;
 
     } else {
         // Try to send byte
@@ -186,11 +218,59 @@ INTERRUPT(24) {
 // Detail (master receiver)
 // https://ww1.microchip.com/downloads/en/DeviceDoc/Atmel-7810-Automotive-Microcontrollers-ATmega328P_Datasheet.pdf#page=183
 
+boolean two_wires_set_frequency(uint32_t local_frequency) {
+    // SCL = F_CPU / (16 + multiplier * TWBR). Both divisions round up, so that the frequency never
+    // goes above the requested one
+    uint32_t divider = (F_CPU + local_frequency - 1) / local_frequency;
+    if (divider < 16 + 2 * MIN_TWBR) {
+        return false;
+    }
+
+    for (uint8_t prescaler = 0; prescaler <= MAX_PRESCALER; prescaler++) {
+        // 2 * 4^prescaler
+        uint16_t multiplier = 2 << (2 * prescaler);
+        uint32_t twbr       = (divider - 16 + multiplier - 1) / multiplier;
+        if (twbr > 0xFF) {
+            continue;
+        }
+
+        // Only between transfers
+        write_two_wires_join();
+
+        TWBR      = twbr;
+        TWSR      = prescaler << TWPS0;
+        frequency = F_CPU / (16 + multiplier * twbr);
+        // Rounded up, budgets stay on the safe side
+        byte_us = (9 * 1000000UL + frequency - 1) / frequency;
+        return true;
+    }
+    return false;
+}
+
+uint32_t two_wires_frequency() {
+    return frequency;
+}
+
+uint16_t two_wires_byte_us() {
+    return byte_us;
+}
+
+uint32_t two_wires_negotiate_frequency(uint8_t local_slave_address, uint32_t local_frequency) {
+    if (two_wires_set_frequency(local_frequency)) {
+        // An empty write: the slave NACKs its address, or the bus fails, if it is too fast
+        uint8_t dummy_data = 0x00;
+        if (write_two_wires_sync(local_slave_address, &dummy_data, 0) == ALL_GOOD) {
+            return frequency;
+        }
+    }
+
+    two_wires_set_frequency(TWO_WIRES_FREQUENCY);
+    return frequency;
+}
+
 void init_two_wires() {
     // Set Bit Rate
-    TWBR = TWBR_VALUE;
-
-    TWSR = 0;
+    two_wires_set_frequency(TWO_WIRES_FREQUENCY);
 
     PORTC |= (1 << 4) | (1 << 5); // Enable internal pull-ups
 
@@ -202,29 +282,82 @@ void init_two_wires() {
 }
 
 
-void write_two_wires_start(uint8_t local_slave_address,
-                           uint8_t local_data[],
-                           uint8_t local_data_len) {
+void write_two_wires_begin(uint8_t local_slave_address) {
+    write_two_wires_join();
+
+    // Bytes left behind by a failed transfer
+    while (tw_out_dequeue(0)) {
+    }
+
     error         = ALL_GOOD;
     retries_count = 0;
 
-    slave_address = local_slave_address;
-    tw_out_enqueue_n(local_data, local_data_len);
+    slave_address    = local_slave_address;
+    transaction_open = true;
 
+    // Get the bus while the segments are prepared
+    busy = true;
     TWCR = DEFAULT_TWCR | TWSTA | TWINT;
 }
 
-ERROR write_two_wires_join() {
-    boolean queue_empty = false;
-    CRITICAL {
-        queue_empty = tw_out_empty();
+boolean write_two_wires_segment(uint8_t data[], uint8_t data_len) {
+    if (!tw_out_enqueue_n(data, data_len)) {
+        return false;
+    }
+
+    // The interrupt is disabled while stalled, nothing else touches the bus
+    if (stalled) {
+        stalled = false;
+        send_byte_and_continue();
+    }
+    return true;
+}
+
+void write_two_wires_end() {
+    transaction_open = false;
+
+    // Otherwise the interrupt sends STOP once tw_out is empty
+    if (stalled) {
+        stalled = false;
+        TWCR    = DEFAULT_TWCR | TWSTO | TWINT;
+        busy    = false;
+    }
+}
+
+boolean write_two_wires_start(uint8_t local_slave_address,
+                              uint8_t local_data[],
+                              uint8_t local_data_len) {
+    // Checked before taking the bus: begin empties the queue, anything up to its size then fits
+    if (local_data_len > sizeof(tw_out_queue)) {
+        return false;
     }
 
-    while (!queue_empty) {
+    write_two_wires_begin(local_slave_address);
+    boolean queued = write_two_wires_segment(local_data, local_data_len);
+    write_two_wires_end();
+    return queued;
+}
+
+boolean write_two_wires_append(uint8_t data[], uint8_t data_len) {
+    return tw_out_enqueue_n(data, data_len);
+}
+
+void two_wires_set_refill(uint8_t local_slave_address, void (*refill)()) {
+    refill_slave_address = local_slave_address;
+    refill_callback      = refill;
+}
+
+boolean two_wires_busy() {
+    return busy;
+}
+
+uint8_t two_wires_free() {
+    return sizeof(tw_out_queue) - tw_out_len();
+}
+
+ERROR write_two_wires_join() {
+    while (busy) {
         sleep();
-        CRITICAL {
-            queue_empty = tw_out_empty();
-        }
     }
 
 
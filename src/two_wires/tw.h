@@ -3,16 +3,51 @@
 
 #include "../utils/utils.h"
 
+// Standard mode, the SCL frequency after init
+#define TWO_WIRES_FREQUENCY 100000
+// Fast mode, needs adequate pull-ups
+#define TWO_WIRES_FAST_FREQUENCY 400000
 
 void init_two_wires();
 
+// Picks TWBR and the prescaler for the closest frequency not above `local_frequency`. Waits for the
+// current transfer. Returns false, changing nothing, if the frequency cannot be reached
+boolean two_wires_set_frequency(uint32_t local_frequency);
+// Tries `local_frequency` with an empty write to the slave, falls back to TWO_WIRES_FREQUENCY if it
+// is not acknowledged (once retries are exhausted). Returns the frequency in use
+uint32_t two_wires_negotiate_frequency(uint8_t local_slave_address, uint32_t local_frequency);
+uint32_t two_wires_frequency();
+// Bus time of a byte plus its ACK, rounded up
+uint16_t two_wires_byte_us();
+
 ERROR
 write_two_wires_sync(uint8_t local_slave_address, uint8_t local_data[], uint8_t local_data_len);
 
-void  write_two_wires_start(uint8_t local_slave_address,
-                            uint8_t local_data[],
-                            uint8_t local_data_len);
-ERROR write_two_wires_join();
+// Single segment transaction, waits for the previous transfer. Returns false, sending nothing, if
+// the data is larger than the queue
+boolean write_two_wires_start(uint8_t local_slave_address,
+                              uint8_t local_data[],
+                              uint8_t local_data_len);
+ERROR   write_two_wires_join();
+
+// Transaction: all the segments written between begin and end are sent after a single START and
+// SLA+W, the bus is held (SCL stretched) while waiting for the next segment.
+// begin waits for the previous transfer to finish
+void write_two_wires_begin(uint8_t local_slave_address);
+// All or nothing: false when the queue is full (backpressure), retry once it drained
+boolean write_two_wires_segment(uint8_t data[], uint8_t data_len);
+void    write_two_wires_end();
+
+// Whether a transfer is in progress
+boolean two_wires_busy();
+// Bytes that can be queued right now
+uint8_t two_wires_free();
+
+// `refill` runs in the TWI interrupt whenever the bytes of a transfer to `local_slave_address` are
+// all sent. It may append more with write_two_wires_append(), which keeps the bus, otherwise STOP
+// is sent. While a transfer is in progress, the refill is the only one allowed to append
+void    two_wires_set_refill(uint8_t local_slave_address, void (*refill)());
+boolean write_two_wires_append(uint8_t data[], uint8_t data_len);
 
 void scan_i2c_addresses();
 
@@ -12,14 +12,51 @@ typedef uint8_t boolean;
 #define MANAGE_BIT(address, bit_n, val) address = (address & ~(1 << bit_n)) | (val << bit_n)
 #define GET_BIT(address, bit_n)         ((address >> bit_n) & 1)
 
-#define EXPAND_ADDRESS_TYPE(address, type) *((volatile type *) (address))
+#ifdef HOST
+// Host simulation build (see host/): registers are backed by a plain array instead of the I/O
+// space, so the game logic can run on a desktop machine
+extern volatile uint8_t host_registers[];
+    #define EXPAND_ADDRESS_TYPE(address, type) *((volatile type *) (host_registers + (address)))
+#else
+    #define EXPAND_ADDRESS_TYPE(address, type) *((volatile type *) (address))
+#endif
 #define EXPAND_ADDRESS(address)            EXPAND_ADDRESS_TYPE(address, uint8_t)
 #define EXPAND_ADDRESS_16(address)         EXPAND_ADDRESS_TYPE(address, uint16_t)
 #define BIT(name, num)                     static const uint8_t name = (1 << num)
 #define BIT_NO(name, num)                  static const uint8_t name = num##U
 
-#define INTERRUPT(n)                                                                               \
-    void __attribute__((__signal__, __used__, __externally_visible__)) __vector_##n(void)
+#ifdef HOST
+    #define INTERRUPT(n) void __vector_##n(void)
+#else
+    #define INTERRUPT(n)                                                                           \
+        void __attribute__((__signal__, __used__, __externally_visible__)) __vector_##n(void)
+#endif
+
+// Constant data kept in flash instead of being copied to the (2KB) RAM at boot.
+// It lives in a different address space, so it can only be read with `lpm`
+#ifdef HOST
+    #define PROGMEM
+__attribute__((always_inline)) inline uint8_t progmem_read_byte(const void *address) {
+    return *(const uint8_t *) address;
+}
+__attribute__((always_inline)) inline uint16_t progmem_read_word(const void *address) {
+    return *(const uint16_t *) address;
+}
+#else
+    #define PROGMEM __attribute__((__progmem__))
+__attribute__((always_inline)) inline uint8_t progmem_read_byte(const void *address) {
+    uint8_t result;
+    asm("lpm %0, Z" : "=r"(result) : "z"(address));
+    return result;
+}
+__attribute__((always_inline)) inline uint16_t progmem_read_word(const void *address) {
+    uint16_t result;
+    asm("lpm %A0, Z+\n\t"
+        "lpm %B0, Z"
+        : "=r"(result), "+z"(address));
+    return result;
+}
+#endif
 
 // Fancy "hack" to let us use curly brackets. Thanks AI
 #define CRITICAL                                                                                   \
@@ -44,7 +81,8 @@ typedef enum __attribute__((packed)) {
     TWO_WIRES_NO_START_ACK,
     TWO_WIRES_NO_DATA_ACK,
     TWO_WIRES_ARBITRATION_LOST,
-    LCD_INVALID_ROW_OR_COL
+    LCD_INVALID_ROW_OR_COL,
+    SCHEDULER_MAX_TASKS_REACHED
 } ERROR;
 
 void init_errors();
@@ -58,16 +96,19 @@ __attribute__((always_inline)) inline void manage_global_interrupts(boolean enab
     MANAGE_BIT(SREG, 7, enable);
 };
 
-#define MEASURE_TIME(var_name_param)                                                               \
+#define MEASURE_TIME(var_name_param) MEASURE_TIME_WITH(var_name_param, get_current_time)
+// Same in microseconds, for blocks shorter than a few ms
+#define MEASURE_TIME_US(var_name_param) MEASURE_TIME_WITH(var_name_param, get_current_us)
+
+#define MEASURE_TIME_WITH(var_name_param, clock)                                                   \
     uint32_t var_name_param = 0;            /* Declare and initialize the duration variable */     \
     uint32_t __start_time_##var_name_param; /* Unique temporary variable for start time */         \
     /* This loop runs once: records start time, allows block execution, then calculates duration   \
      */                                                                                            \
-    for (int __run_once_##var_name_param =                                                         \
-             (__start_time_##var_name_param = get_current_time(), 1);                              \
+    for (int __run_once_##var_name_param = (__start_time_##var_name_param = clock(), 1);           \
          __run_once_##var_name_param;                                                              \
          __run_once_##var_name_param = 0,                                                          \
-             var_name_param          = get_current_time() - __start_time_##var_name_param)
+             var_name_param          = clock() - __start_time_##var_name_param)
 /* The user's code block becomes the body of this for-loop */
 
 